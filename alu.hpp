@@ -1,7 +1,126 @@
 #pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
 #include "combinational_circuit.hpp"
+#include "cost_model.hpp"
 #include "lsu.hpp"
 
+/*
+Opcodes of the ALU operations, in handler table order.
+COUNT is not an operation; it is the number of opcodes.
+*/
+enum class ALUOpcode : uint8_t { ADD, SUB, MUL, MAC, DIV, INC, DEC, NEG, SHL, SHR, SAR, ROL, ROR, CMP, MULH, COUNT };
+
+// Mnemonics of the ALU operations, indexed by ALUOpcode.
+inline constexpr std::array<std::string_view, static_cast<uint8_t>(ALUOpcode::COUNT)> ALU_MNEMONICS = {
+    "ADD", "SUB", "MUL", "MAC", "DIV", "INC", "DEC", "NEG", "SHL", "SHR", "SAR", "ROL", "ROR", "CMP", "MULH"};
+
+/*
+Uniform operand bundle for ALU::execute.
+
+Each operation reads only the fields its named entry point takes; the rest may stay null.
+*/
+struct ALUOperands {
+    Register* lhs = nullptr; // Destination / left-hand operand (MAC: multiplicand)
+    const Register* rhs = nullptr; // Right-hand operand (MAC: multiplier)
+    Register* temp = nullptr; // Caller-provided temporary
+    const Register* zero = nullptr; // Caller-provided zero register
+    Register* quotient = nullptr; // DIV: quotient temporary
+    Register* acc_hi = nullptr; // MAC: upper half of the accumulator
+    Register* acc_lo = nullptr; // MAC: lower half of the accumulator
+    uint8_t count = 0; // Shift/rotate count
+};
+
+/*
+A cross-checked operation whose native result differed from the gate model.
+
+Register values are listed in ALUOperands field order (lhs, rhs, temp, zero, quotient, acc_hi,
+acc_lo); fields the operation does not use hold 0. Flags are listed as CF, ZF, SF, OF.
+*/
+struct ALUDivergence {
+    ALUOpcode opcode; // Operation that diverged
+    uint64_t operation; // Index of the operation among all operations the ALU executed
+    uint8_t count; // Shift/rotate count operand
+    std::array<WORD, 7> before = {}; // Operand registers before the operation
+    std::array<WORD, 7> gate = {}; // Operand registers after the gate-level evaluation
+    std::array<WORD, 7> native = {}; // Operand registers after the native evaluation
+    std::array<bool, 4> gate_flags = {}; // Flags after the gate-level evaluation
+    std::array<bool, 4> native_flags = {}; // Flags after the native evaluation
+    CostModel::Cost gate_cost = {}; // Cost reported by the gate-level evaluation
+    CostModel::Cost native_cost = {}; // Cost reported by the native evaluation
+
+    /*
+    Stream insertion operator for reporting a divergence.
+
+    Example:
+    DEC #17: lhs 0x0032 -> gate 0x0031, native 0x0032; flags (CF ZF SF OF) gate 0000, native 0100;
+
+    Only the registers and the flags or cost that differ are listed.
+    */
+    friend auto& operator<<(auto& os, const ALUDivergence& divergence) {
+        constexpr std::string_view FIELDS[] = {"lhs", "rhs", "temp", "zero", "quotient", "acc_hi", "acc_lo"};
+        constexpr char DIGITS[] = "0123456789abcdef";
+        const auto hex = [&](const WORD value) -> auto& {
+            os << "0x";
+
+            for (int8_t shift = ARCHITECTURE - 4; shift >= 0; shift -= 4) {
+                os << DIGITS[value >> shift & 0xF];
+            }
+            return os;
+        };
+        os << ALU_MNEMONICS[static_cast<uint8_t>(divergence.opcode)] << " #" << divergence.operation << ':';
+
+        for (uint8_t i = 0; i < std::size(FIELDS); i++) {
+            if (divergence.gate[i] != divergence.native[i]) {
+                os << ' ' << FIELDS[i] << ' ';
+                hex(divergence.before[i]) << " -> gate ";
+                hex(divergence.gate[i]) << ", native ";
+                hex(divergence.native[i]) << ';';
+            }
+        }
+        if (divergence.gate_flags != divergence.native_flags) {
+            os << " flags (CF ZF SF OF) gate ";
+
+            for (const bool flag : divergence.gate_flags) {
+                os << flag;
+            }
+            os << ", native ";
+
+            for (const bool flag : divergence.native_flags) {
+                os << flag;
+            }
+            os << ';';
+        }
+        if (divergence.gate_cost.cycles != divergence.native_cost.cycles || divergence.gate_cost.depth != divergence.native_cost.depth) {
+            os << " cost gate " << divergence.gate_cost.cycles << '/' << divergence.gate_cost.depth << ", native "
+               << divergence.native_cost.cycles << '/' << divergence.native_cost.depth << ';';
+        }
+        return os;
+    }
+};
+
+/*
+Sampled lockstep checker state of a Fidelity::CHECKED ALU.
+
+Every `sample_interval`-th operation (1 checks all, 0 disables checking) is evaluated natively
+on the operand registers and, in lockstep, gate by gate on shadow copies of them. Registers,
+flags and cost are compared and every mismatch is recorded in `divergences`.
+*/
+struct ALUChecker {
+    uint32_t sample_interval = 256; // Cross-check one operation in sample_interval
+    uint64_t operations = 0; // Operations executed
+    uint64_t samples = 0; // Operations cross-checked against the gate model
+    std::vector<ALUDivergence> divergences; // Cross-checked operations whose results differed
+    std::unique_ptr<Register[]> shadow; // Shadow register copies the gate model runs on
+};
+
 /*
 Arithmetic Logic Unit (ALU)
 
@@ -13,23 +132,49 @@ Flags:
 - SF (Sign Flag): Set to the most significant bit (MSB) of the result.
 - OF (Overflow Flag): Set if signed overflow occurs in two's complement arithmetic.
 
+Cost:
+- Every operation reports its modeled cycle count and logic depth (see CostModel) in `cost`,
+  alongside the flags. Data-dependent costs (DIV iterations, MUL partial-product adds, INC/DEC
+  ripple length, rotate steps) reflect the operands actually processed.
+
+Fidelity:
+- The template parameter FIDELITY selects how every operation is evaluated (see Fidelity):
+  gate by gate, with byte-slice adder lookups, with native word arithmetic, or natively with
+  sampled lockstep cross-checks against the gate model (CHECKED, see ALUChecker).
+- Each operation also takes a Fidelity template argument defaulting to FIDELITY, so a single
+  call can override the policy.
+- Native paths produce the same registers, flags and cost as the gate model. They assume the
+  caller-provided zero register holds 0 and that operands do not alias the temporaries.
+
 Supported operations:
-- ADD: Adds two registers using a ripple-carry adder.
+- ADD: Adds two registers using a ripple-carry adder (optionally byte-sliced, see Fidelity).
 - SUB: Subtracts two registers using two's complement addition.
 - MUL: Multiplies two registers using shift-and-add method.
+- MAC: Signed multiply-accumulate into a register pair using a Wallace tree multiplier.
+- MULH: Upper half of the unsigned product, on the same Wallace tree multiplier.
 - INC/DEC: Increment or decrement a register by 1.
 - NEG: Computes the two's complement negation of a register.
 - SHL/SHR: Logical shift left/right.
 - SAR: Arithmetic shift right.
 - ROL/ROR: Rotate left/right.
 - CMP: Compare two registers without modifying operands.
+
+Dispatch:
+- Besides the named operations, `execute(opcode, operands)` runs any operation through a uniform
+  entry point. It indexes a constexpr-generated table of handlers by opcode, so a decoder
+  dispatches with a single indirect call instead of a switch.
 */
+template <Fidelity FIDELITY = Fidelity::GATE>
 class ALU {
 public:
     Bit CF; // Carry Flag
     Bit ZF; // Zero Flag
     Bit SF; // Sign Flag
     Bit OF; // Overflow Flag
+    CostModel::Cost cost; // Modeled cost of the most recent operation
+
+    // Lockstep checker state; only present with Fidelity::CHECKED
+    [[no_unique_address]] std::conditional_t<FIDELITY == Fidelity::CHECKED, ALUChecker, std::monostate> checker;
 
     /*
     Adds two registers and updates ALU flags.
@@ -37,6 +182,9 @@ public:
     Performs bitwise addition of `lhs` and `rhs` using a ripple-carry adder.
     The result is stored in `lhs`.
 
+    Fidelity::LOOKUP adds a byte per CombinationalCircuits::BYTE_ADDER lookup and
+    Fidelity::NATIVE uses host word arithmetic; results and flags are bit-identical.
+
     Flags updated:
     - ZF: Set to 1 if the result is zero.
     - SF: Set to the MSB of the result.
@@ -47,24 +195,39 @@ public:
     - lhs: Left-hand side operand; stores the result.
     - rhs: Right-hand side operand.
     */
+    template <Fidelity F = FIDELITY>
     constexpr void ADD(Register& lhs, const Register& rhs) noexcept {
+        if constexpr (F == Fidelity::CHECKED) {
+            CHECK<ALUOpcode::ADD>({.lhs = &lhs, .rhs = &rhs});
+            return;
+        }
         const Bit lhs_MSB_before = lhs.MSB();
         const Bit rhs_MSB = rhs.MSB();
         Bit carry = false;
         ZF = true;
 
-        for (uint8_t i = 0; i < ARCHITECTURE; i++) {
-            const auto [SUM, CARRY] = CombinationalCircuits::FULL_ADDER(lhs[i], rhs[i], carry);
-            lhs[i] = SUM;
-            carry = CARRY;
+        if constexpr (F == Fidelity::LOOKUP) {
+            carry = BYTE_SLICE_ADD(lhs, rhs, false, carry);
+        } else if constexpr (F == Fidelity::NATIVE) {
+            const DWORD sum = static_cast<DWORD>(static_cast<WORD>(lhs)) + static_cast<WORD>(rhs);
+            LSU::MOV(lhs, static_cast<WORD>(sum));
+            carry = (sum >> ARCHITECTURE & 1) != 0;
+            ZF = static_cast<WORD>(sum) == 0;
+        } else {
+            for (uint8_t i = 0; i < ARCHITECTURE; i++) {
+                const auto [SUM, CARRY] = CombinationalCircuits::FULL_ADDER(lhs[i], rhs[i], carry);
+                lhs[i] = SUM;
+                carry = CARRY;
 
-            if (SUM) {
-                ZF = false;
+                if (SUM) {
+                    ZF = false;
+                }
             }
         }
         SF = lhs.MSB();
         CF = carry;
         OF = lhs_MSB_before == rhs_MSB & SF != lhs_MSB_before;
+        cost = CostModel::ADD();
     }
 
     /*
@@ -74,6 +237,9 @@ public:
         lhs = lhs + (~rhs + 1)
     Operates in-place.
 
+    Fidelity::LOOKUP adds a byte per CombinationalCircuits::BYTE_ADDER lookup and
+    Fidelity::NATIVE uses host word arithmetic; results and flags are bit-identical.
+
     Flags updated:
     - ZF: Set to 1 if the result is zero.
     - SF: Set to MSB of the result.
@@ -84,48 +250,211 @@ public:
     - lhs: Left-hand side operand; stores the result.
     - rhs: Right-hand side operand.
     */
+    template <Fidelity F = FIDELITY>
     constexpr void SUB(Register& lhs, const Register& rhs) noexcept {
+        if constexpr (F == Fidelity::CHECKED) {
+            CHECK<ALUOpcode::SUB>({.lhs = &lhs, .rhs = &rhs});
+            return;
+        }
         const Bit lhs_MSB_before = lhs.MSB();
         const Bit rhs_MSB = rhs.MSB();
         Bit carry = true;
         ZF = true;
 
-        for (uint8_t i = 0; i < ARCHITECTURE; i++) {
-            const auto [SUM, CARRY] = CombinationalCircuits::FULL_ADDER(lhs[i], ~rhs[i], carry);
-            lhs[i] = SUM;
-            carry = CARRY;
+        if constexpr (F == Fidelity::LOOKUP) {
+            carry = BYTE_SLICE_ADD(lhs, rhs, true, carry);
+        } else if constexpr (F == Fidelity::NATIVE) {
+            const DWORD sum = static_cast<DWORD>(static_cast<WORD>(lhs)) + static_cast<WORD>(~static_cast<WORD>(rhs)) + 1;
+            LSU::MOV(lhs, static_cast<WORD>(sum));
+            carry = (sum >> ARCHITECTURE & 1) != 0;
+            ZF = static_cast<WORD>(sum) == 0;
+        } else {
+            for (uint8_t i = 0; i < ARCHITECTURE; i++) {
+                const auto [SUM, CARRY] = CombinationalCircuits::FULL_ADDER(lhs[i], ~rhs[i], carry);
+                lhs[i] = SUM;
+                carry = CARRY;
 
-            if (SUM) {
-                ZF = false;
+                if (SUM) {
+                    ZF = false;
+                }
             }
         }
         SF = lhs.MSB();
         CF = ~carry;
         OF = lhs_MSB_before != rhs_MSB & SF != lhs_MSB_before;
+        cost = CostModel::SUB();
     }
 
     /*
     Multiplies two registers using shift-and-add, storing the result in lhs.
 
-    Flags updated indirectly via ADD:
-    - ZF, SF, CF, OF
+    Flags are left by the final SHL of the shifted multiplicand, which has shifted every bit out:
+    - ZF: 1
+    - SF, CF, OF: 0
 
     Parameters:
     - lhs: Multiplicand; will store the result.
-    - rhs: Multiplier; read-only.
+    - rhs: Multiplier; read-only. Must not alias lhs or temp.
     - temp: Temporary register for shifting and accumulation; provided by caller.
     - zero: Temporary register representing zero; used for SHL flag updates.
     */
+    template <Fidelity F = FIDELITY>
     constexpr void MUL(Register& lhs, const Register& rhs, Register& temp, const Register& zero) noexcept {
+        if constexpr (F == Fidelity::CHECKED) {
+            CHECK<ALUOpcode::MUL>({.lhs = &lhs, .rhs = &rhs, .temp = &temp, .zero = &zero});
+            return;
+        } else if constexpr (F == Fidelity::NATIVE) {
+            const WORD multiplier = static_cast<WORD>(rhs);
+            LSU::MOV(lhs, static_cast<WORD>(static_cast<DWORD>(static_cast<WORD>(lhs)) * multiplier));
+            LSU::MOV(temp, static_cast<WORD>(0));
+            ZF = true;
+            SF = CF = OF = false;
+            cost = CostModel::MUL(std::popcount(multiplier));
+            return;
+        }
+        uint8_t adds = 0;
         LSU::MOV(temp, lhs);
         LSU::MOV(lhs, zero);
 
         for (uint8_t i = 0; i < ARCHITECTURE; i++) {
             if (rhs[i]) {
-                ADD(lhs, temp);
+                ADD<F>(lhs, temp);
+                adds++;
+            }
+            SHL<F>(temp, 1, zero, temp);
+        }
+        cost = CostModel::MUL(adds);
+    }
+
+    /*
+    Signed multiply-accumulate: {acc_hi, acc_lo} += lhs * rhs.
+
+    The accumulator is a register pair of 2 * ARCHITECTURE bits (acc_hi holds the upper half).
+    Unlike MUL followed by ADD, no caller-provided temp/zero registers are needed and flags are
+    updated once, for the final accumulation only.
+
+    Gate-level model (Fidelity::GATE):
+    - Partial products of the sign-extended multiplicand are formed with AND gates; the row of
+      the multiplier sign bit is inverted with a carry-in of 1 (two's complement subtraction).
+    - A Wallace tree of FULL_ADDER carry-save stages reduces the rows to two.
+    - A ripple-carry adder resolves the product, which feeds a second ripple-carry adder that
+      accumulates it into the register pair.
+
+    Fidelity::NATIVE computes the same result and flags with host word arithmetic.
+
+    Flags updated:
+    - ZF: Set if the accumulator is zero.
+    - SF: MSB of the accumulator.
+    - CF: Set if the accumulation carries out of the accumulator MSB.
+    - OF: Set if signed overflow occurs during the accumulation.
+
+    Parameters:
+    - acc_hi: Upper half of the accumulator; stores the result.
+    - acc_lo: Lower half of the accumulator; stores the result.
+    - lhs: Multiplicand; read-only.
+    - rhs: Multiplier; read-only.
+    */
+    template <Fidelity F = FIDELITY>
+    constexpr void MAC(Register& acc_hi, Register& acc_lo, const Register& lhs, const Register& rhs) noexcept {
+        constexpr uint8_t WIDTH = 2 * ARCHITECTURE;
+
+        if constexpr (F == Fidelity::CHECKED) {
+            CHECK<ALUOpcode::MAC>({.lhs = const_cast<Register*>(&lhs), .rhs = &rhs, .acc_hi = &acc_hi, .acc_lo = &acc_lo});
+            return;
+        } else if constexpr (F == Fidelity::NATIVE) {
+            DWORD multiplicand = static_cast<WORD>(lhs);
+            DWORD multiplier = static_cast<WORD>(rhs);
+            const DWORD acc = static_cast<DWORD>(static_cast<WORD>(acc_hi)) << ARCHITECTURE | static_cast<WORD>(acc_lo);
+
+            if (lhs.MSB()) {
+                multiplicand |= ~DWORD(0) << ARCHITECTURE;
+            }
+            if (rhs.MSB()) {
+                multiplier |= ~DWORD(0) << ARCHITECTURE;
+            }
+            const DWORD product = multiplicand * multiplier;
+            const DWORD result = acc + product;
+            const bool acc_MSB = acc >> (WIDTH - 1);
+            const bool product_MSB = product >> (WIDTH - 1);
+
+            LSU::MOV(acc_lo, static_cast<WORD>(result));
+            LSU::MOV(acc_hi, static_cast<WORD>(result >> ARCHITECTURE));
+            ZF = result == 0;
+            SF = acc_hi.MSB();
+            CF = result < acc;
+            OF = acc_MSB == product_MSB && static_cast<bool>(SF) != acc_MSB;
+            cost = CostModel::MAC();
+            return;
+        }
+        Bit product[WIDTH] = {};
+        PRODUCT<true>(lhs, rhs, product);
+
+        // Accumulating adder over the register pair
+        const Bit acc_MSB_before = acc_hi.MSB();
+        Bit carry = false;
+        ZF = true;
+
+        for (uint8_t i = 0; i < WIDTH; i++) {
+            Register& acc = i < ARCHITECTURE ? acc_lo : acc_hi;
+            const uint8_t bit = i % ARCHITECTURE;
+            const auto [SUM, CARRY] = CombinationalCircuits::FULL_ADDER(acc[bit], product[i], carry);
+            acc[bit] = SUM;
+            carry = CARRY;
+
+            if (SUM) {
+                ZF = false;
             }
-            SHL(temp, 1, zero, temp);
         }
+        SF = acc_hi.MSB();
+        CF = carry;
+        OF = acc_MSB_before == product[WIDTH - 1] & SF != acc_MSB_before;
+        cost = CostModel::MAC();
+    }
+
+    /*
+    Unsigned multiply high: lhs = (lhs * rhs) >> ARCHITECTURE, the upper half of the full
+    unsigned product. Followed by a shift, it divides by a constant (see Peephole).
+
+    Gate-level model (Fidelity::GATE): MAC's Wallace tree multiplier on unsigned operands
+    (PRODUCT), keeping the upper half of the product.
+
+    Flags updated:
+    - ZF: Set if the result is zero.
+    - SF: MSB of the result.
+    - CF, OF: 0
+
+    Parameters:
+    - lhs: Multiplicand; will store the result.
+    - rhs: Multiplier; read-only.
+    */
+    template <Fidelity F = FIDELITY>
+    constexpr void MULH(Register& lhs, const Register& rhs) noexcept {
+        if constexpr (F == Fidelity::CHECKED) {
+            CHECK<ALUOpcode::MULH>({.lhs = &lhs, .rhs = &rhs});
+            return;
+        } else if constexpr (F == Fidelity::NATIVE) {
+            const WORD result = static_cast<WORD>(static_cast<DWORD>(static_cast<WORD>(lhs)) * static_cast<WORD>(rhs) >> ARCHITECTURE);
+            LSU::MOV(lhs, result);
+            ZF = result == 0;
+            SF = lhs.MSB();
+            CF = OF = false;
+            cost = CostModel::MULH();
+            return;
+        }
+        Bit product[2 * ARCHITECTURE] = {};
+        PRODUCT<false>(lhs, rhs, product);
+        ZF = true;
+
+        for (uint8_t i = 0; i < ARCHITECTURE; i++) {
+            lhs[i] = product[ARCHITECTURE + i];
+
+            if (product[ARCHITECTURE + i]) {
+                ZF = false;
+            }
+        }
+        SF = lhs.MSB();
+        CF = OF = false;
+        cost = CostModel::MULH();
     }
 
     /*
@@ -144,32 +473,58 @@ public:
     - temp: Temporary register for repeated subtraction; provided by caller.
     - zero: Zero register; provided by caller.
     */
+    template <Fidelity F = FIDELITY>
     constexpr void DIV(Register& lhs, const Register& rhs, Register& quotient, Register& temp, const Register& zero) noexcept {
-        CMP(rhs, zero, temp);
+        if constexpr (F == Fidelity::CHECKED) {
+            CHECK<ALUOpcode::DIV>({.lhs = &lhs, .rhs = &rhs, .temp = &temp, .zero = &zero, .quotient = &quotient});
+            return;
+        } else if constexpr (F == Fidelity::NATIVE) {
+            const WORD dividend = static_cast<WORD>(lhs);
+            const WORD divisor = static_cast<WORD>(rhs);
+
+            if (divisor == 0) {
+                LSU::MOV(temp, divisor);
+                LSU::MOV(lhs, zero);
+                ZF = CF = OF = true;
+                SF = false;
+                cost = CostModel::DIV(0);
+                return;
+            }
+            const WORD result = dividend / divisor;
+            LSU::MOV(quotient, result);
+            LOAD_RESULT(lhs, temp, result);
+            cost = CostModel::DIV(result + 1u);
+            return;
+        }
+        CMP<F>(rhs, zero, temp);
 
         if (ZF) {
             LSU::MOV(lhs, zero);
             ZF = CF = OF = true;
             SF = false;
+            cost = CostModel::DIV(0);
             return;
         }
+        uint32_t iterations = 0;
         LSU::MOV(quotient, zero);
         LSU::MOV(temp, lhs);
 
         while (true) {
-            SUB(temp, rhs);
+            SUB<F>(temp, rhs);
+            iterations++;
 
             if (CF) {
-                ADD(temp, rhs);
+                ADD<F>(temp, rhs);
                 break;
             }
-            INC(quotient);
+            INC<F>(quotient);
         }
         LSU::MOV(lhs, quotient);
         SF = lhs.MSB();
-        CMP(lhs, zero, temp);
+        CMP<F>(lhs, zero, temp);
         CF = false;
         OF = false;
+        cost = CostModel::DIV(iterations);
     }
 
     /*
@@ -184,29 +539,48 @@ public:
     Parameters:
     - reg: Register to increment; stores the result.
     */
+    template <Fidelity F = FIDELITY>
     constexpr void INC(Register& reg) noexcept {
+        if constexpr (F == Fidelity::CHECKED) {
+            CHECK<ALUOpcode::INC>({.lhs = &reg});
+            return;
+        }
         const Bit MSB_before = reg.MSB();
         Bit carry = true;
+        uint8_t bits = 0;
         ZF = true;
 
-        for (uint8_t i = 0; i < ARCHITECTURE; i++) {
-            const auto [SUM, CARRY] = CombinationalCircuits::FULL_ADDER(reg[i], false, carry);
-            reg[i] = SUM;
-            carry = CARRY;
-
-            if (SUM) {
-                ZF = false;
-            }
-            if (!CARRY) {
-                break;
+        if constexpr (F == Fidelity::NATIVE) {
+            const WORD value = static_cast<WORD>(reg);
+            const int ripple = std::countr_one(value) + 1;
+            bits = ripple < ARCHITECTURE ? ripple : ARCHITECTURE;
+            LSU::MOV(reg, static_cast<WORD>(value + 1));
+            ZF = value == static_cast<WORD>(~0u);
+        } else {
+            for (uint8_t i = 0; i < ARCHITECTURE; i++, bits++) {
+                const auto [SUM, CARRY] = CombinationalCircuits::FULL_ADDER(reg[i], false, carry);
+                reg[i] = SUM;
+                carry = CARRY;
+
+                if (SUM) {
+                    ZF = false;
+                }
+                if (!CARRY) {
+                    bits++;
+                    break;
+                }
             }
         }
         SF = reg.MSB();
         OF = MSB_before == false & SF == true;
+        cost = CostModel::INC(bits);
     }
 
     /*
-    Decrements a register by 1 using ripple-carry addition of -1.
+    Decrements a register by 1 using ripple-carry addition of -1 (all ones, carry-in 0).
+
+    The ripple stops at the first stage that produces a carry: every higher stage would add
+    1 + 1 and leave its bit unchanged. The zero detect still covers those untouched bits.
 
     Flags updated:
     - ZF: Set if result is zero.
@@ -217,25 +591,46 @@ public:
     Parameters:
     - reg: Register to decrement; stores the result.
     */
+    template <Fidelity F = FIDELITY>
     constexpr void DEC(Register& reg) noexcept {
+        if constexpr (F == Fidelity::CHECKED) {
+            CHECK<ALUOpcode::DEC>({.lhs = &reg});
+            return;
+        }
         const Bit MSB_before = reg.MSB();
-        Bit carry = true;
+        Bit carry = false;
+        uint8_t bits = 0;
         ZF = true;
 
-        for (uint8_t i = 0; i < ARCHITECTURE; i++) {
-            const auto [SUM, CARRY] = CombinationalCircuits::FULL_ADDER(reg[i], true, carry);
-            reg[i] = SUM;
-            carry = CARRY;
-
-            if (SUM) {
-                ZF = false;
+        if constexpr (F == Fidelity::NATIVE) {
+            const WORD value = static_cast<WORD>(reg);
+            const int ripple = std::countr_zero(value) + 1;
+            bits = ripple < ARCHITECTURE ? ripple : ARCHITECTURE;
+            LSU::MOV(reg, static_cast<WORD>(value - 1));
+            ZF = value == 1;
+        } else {
+            for (uint8_t i = 0; i < ARCHITECTURE; i++, bits++) {
+                const auto [SUM, CARRY] = CombinationalCircuits::FULL_ADDER(reg[i], true, carry);
+                reg[i] = SUM;
+                carry = CARRY;
+
+                if (SUM) {
+                    ZF = false;
+                }
+                if (CARRY) {
+                    bits++;
+                    break;
+                }
             }
-            if (!CARRY) {
-                break;
+            for (uint8_t i = bits; i < ARCHITECTURE; i++) {
+                if (reg[i]) {
+                    ZF = false;
+                }
             }
         }
         SF = reg.MSB();
         OF = MSB_before == true && SF == false;
+        cost = CostModel::INC(bits);
     }
 
     /*
@@ -248,17 +643,26 @@ public:
     - OF: Set if negating the most negative value.
 
     Parameters:
-    - reg: Register to negate; stores the result.
+    - reg: Register to negate; stores the result. Must not alias temp.
     - temp: Temporary register; provided by caller.
     - zero: Temporary zero register for flag updates.
     */
+    template <Fidelity F = FIDELITY>
     constexpr void NEG(Register& reg, Register& temp, const Register& zero) noexcept {
-        LSU::MOV(temp, zero);
-        SUB(temp, reg);
-        LSU::MOV(reg, temp);
-        CMP(reg, zero, temp);
+        if constexpr (F == Fidelity::CHECKED) {
+            CHECK<ALUOpcode::NEG>({.lhs = &reg, .temp = &temp, .zero = &zero});
+            return;
+        } else if constexpr (F == Fidelity::NATIVE) {
+            LOAD_RESULT(reg, temp, static_cast<WORD>(0u - static_cast<WORD>(reg)));
+        } else {
+            LSU::MOV(temp, zero);
+            SUB<F>(temp, reg);
+            LSU::MOV(reg, temp);
+            CMP<F>(reg, zero, temp);
+        }
         CF = !ZF;
         OF = reg.MSB() && ZF;
+        cost = CostModel::NEG();
     }
 
     /*
@@ -276,19 +680,31 @@ public:
     - zero: Zero register for flag comparison.
     - temp: Temporary register for CMP; provided by caller.
     */
+    template <Fidelity F = FIDELITY>
     constexpr void SHL(Register& reg, const uint8_t count, const Register& zero, Register& temp) noexcept {
+        if constexpr (F == Fidelity::CHECKED) {
+            CHECK<ALUOpcode::SHL>({.lhs = &reg, .temp = &temp, .zero = &zero, .count = count});
+            return;
+        } else if constexpr (F == Fidelity::NATIVE) {
+            LOAD_RESULT(reg, temp, count >= ARCHITECTURE ? WORD(0) : static_cast<WORD>(static_cast<WORD>(reg) << count));
+            OF = count == 1 ? SF ^ CF : false;
+            cost = CostModel::SHIFT();
+            return;
+        }
         if (count == 0) {
             SF = reg.MSB();
-            CMP(reg, zero, temp);
+            CMP<F>(reg, zero, temp);
             OF = CF = false;
+            cost = CostModel::SHIFT();
             return;
         }
         if (count >= ARCHITECTURE) {
             CF = reg[ARCHITECTURE - 1];
             LSU::MOV(reg, zero);
             SF = false;
-            CMP(reg, zero, temp);
+            CMP<F>(reg, zero, temp);
             OF = false;
+            cost = CostModel::SHIFT();
             return;
         }
         CF = reg[ARCHITECTURE - count];
@@ -300,8 +716,9 @@ public:
             reg[i] = false;
         }
         SF = reg.MSB();
-        CMP(reg, zero, temp);
+        CMP<F>(reg, zero, temp);
         OF = count == 1 ? SF ^ CF : false;
+        cost = CostModel::SHIFT();
     }
 
     /*
@@ -319,19 +736,30 @@ public:
     - zero: Zero register for flag comparison.
     - temp: Temporary register for CMP; provided by caller.
     */
+    template <Fidelity F = FIDELITY>
     constexpr void SHR(Register& reg, const uint8_t count, const Register& zero, Register& temp) noexcept {
+        if constexpr (F == Fidelity::CHECKED) {
+            CHECK<ALUOpcode::SHR>({.lhs = &reg, .temp = &temp, .zero = &zero, .count = count});
+            return;
+        } else if constexpr (F == Fidelity::NATIVE) {
+            LOAD_RESULT(reg, temp, count >= ARCHITECTURE ? WORD(0) : static_cast<WORD>(static_cast<WORD>(reg) >> count));
+            cost = CostModel::SHIFT();
+            return;
+        }
         if (count == 0) {
             SF = reg.MSB();
-            CMP(reg, zero, temp);
+            CMP<F>(reg, zero, temp);
             OF = CF = false;
+            cost = CostModel::SHIFT();
             return;
         }
         if (count >= ARCHITECTURE) {
             CF = reg[0];
             LSU::MOV(reg, zero);
             SF = false;
-            CMP(reg, zero, temp);
+            CMP<F>(reg, zero, temp);
             OF = false;
+            cost = CostModel::SHIFT();
             return;
         }
         CF = reg[count - 1];
@@ -343,8 +771,9 @@ public:
             reg[i] = false;
         }
         SF = reg.MSB();
-        CMP(reg, zero, temp);
+        CMP<F>(reg, zero, temp);
         OF = false;
+        cost = CostModel::SHIFT();
     }
 
     /*
@@ -362,11 +791,23 @@ public:
     - zero: Zero register for flag comparison.
     - temp: Temporary register for CMP; provided by caller.
     */
+    template <Fidelity F = FIDELITY>
     constexpr void SAR(Register& reg, const uint8_t count, const Register& zero, Register& temp) noexcept {
+        if constexpr (F == Fidelity::CHECKED) {
+            CHECK<ALUOpcode::SAR>({.lhs = &reg, .temp = &temp, .zero = &zero, .count = count});
+            return;
+        } else if constexpr (F == Fidelity::NATIVE) {
+            const WORD value = static_cast<WORD>(reg);
+            const WORD fill = reg.MSB() ? static_cast<WORD>(~0u) : WORD(0);
+            LOAD_RESULT(reg, temp, count >= ARCHITECTURE ? fill : static_cast<WORD>(value >> count | fill << (ARCHITECTURE - count)));
+            cost = CostModel::SHIFT();
+            return;
+        }
         if (count == 0) {
             SF = reg.MSB();
-            CMP(reg, zero, temp);
+            CMP<F>(reg, zero, temp);
             OF = CF = false;
+            cost = CostModel::SHIFT();
             return;
         }
         const Bit sign = reg.MSB();
@@ -378,8 +819,9 @@ public:
                 reg[i] = sign;
             }
             SF = sign;
-            CMP(reg, zero, temp);
+            CMP<F>(reg, zero, temp);
             OF = false;
+            cost = CostModel::SHIFT();
             return;
         }
         CF = reg[count - 1];
@@ -391,8 +833,9 @@ public:
             reg[i] = sign;
         }
         SF = reg.MSB();
-        CMP(reg, zero, temp);
+        CMP<F>(reg, zero, temp);
         OF = false;
+        cost = CostModel::SHIFT();
     }
 
     /*
@@ -410,13 +853,25 @@ public:
     - zero: Zero register for flag comparison.
     - temp: Temporary register for CMP; provided by caller.
     */
+    template <Fidelity F = FIDELITY>
     constexpr void ROL(Register& reg, uint8_t count, const Register& zero, Register& temp) noexcept {
+        if constexpr (F == Fidelity::CHECKED) {
+            CHECK<ALUOpcode::ROL>({.lhs = &reg, .temp = &temp, .zero = &zero, .count = count});
+            return;
+        }
         count %= ARCHITECTURE;
 
+        if constexpr (F == Fidelity::NATIVE) {
+            LOAD_RESULT(reg, temp, std::rotl(static_cast<WORD>(reg), count));
+            OF = count == 1 ? SF ^ CF : false;
+            cost = CostModel::ROTATE(count);
+            return;
+        }
         if (count == 0) {
             SF = reg.MSB();
-            CMP(reg, zero, temp);
+            CMP<F>(reg, zero, temp);
             OF = CF = false;
+            cost = CostModel::ROTATE(count);
             return;
         }
         for (uint8_t c = 0; c < count; c++) {
@@ -429,8 +884,9 @@ public:
             CF = msb;
         }
         SF = reg.MSB();
-        CMP(reg, zero, temp);
+        CMP<F>(reg, zero, temp);
         OF = count == 1 ? SF ^ CF : false;
+        cost = CostModel::ROTATE(count);
     }
 
     /*
@@ -448,13 +904,25 @@ public:
     - zero: Zero register for flag comparison.
     - temp: Temporary register for CMP; provided by caller.
     */
+    template <Fidelity F = FIDELITY>
     constexpr void ROR(Register& reg, uint8_t count, const Register& zero, Register& temp) noexcept {
+        if constexpr (F == Fidelity::CHECKED) {
+            CHECK<ALUOpcode::ROR>({.lhs = &reg, .temp = &temp, .zero = &zero, .count = count});
+            return;
+        }
         count %= ARCHITECTURE;
 
+        if constexpr (F == Fidelity::NATIVE) {
+            LOAD_RESULT(reg, temp, std::rotr(static_cast<WORD>(reg), count));
+            OF = count == 1 ? reg[ARCHITECTURE - 1] ^ reg[ARCHITECTURE - 2] : false;
+            cost = CostModel::ROTATE(count);
+            return;
+        }
         if (count == 0) {
             SF = reg.MSB();
-            CMP(reg, zero, temp);
+            CMP<F>(reg, zero, temp);
             OF = CF = false;
+            cost = CostModel::ROTATE(count);
             return;
         }
         for (uint8_t c = 0; c < count; c++) {
@@ -467,8 +935,9 @@ public:
             CF = lsb;
         }
         SF = reg.MSB();
-        CMP(reg, zero, temp);
+        CMP<F>(reg, zero, temp);
         OF = count == 1 ? reg[ARCHITECTURE - 1] ^ reg[ARCHITECTURE - 2] : false;
+        cost = CostModel::ROTATE(count);
     }
 
     /*
@@ -488,8 +957,240 @@ public:
     - rhs: Right-hand operand (read-only).
     - temp: Temporary register provided by caller; used for computation.
     */
+    template <Fidelity F = FIDELITY>
     constexpr void CMP(const Register& lhs, const Register& rhs, Register& temp) noexcept {
+        if constexpr (F == Fidelity::CHECKED) {
+            CHECK<ALUOpcode::CMP>({.lhs = const_cast<Register*>(&lhs), .rhs = &rhs, .temp = &temp});
+            return;
+        }
         LSU::MOV(temp, lhs);
-        SUB(temp, rhs);
+        SUB<F>(temp, rhs);
+    }
+
+    /*
+    Executes the operation `opcode` on `operands`.
+
+    Dispatches through HANDLERS with one indirect call; each handler forwards the operand
+    bundle to the named operation.
+
+    Parameters:
+    - opcode: Operation to execute; must be below ALUOpcode::COUNT.
+    - operands: Operands of the operation, as taken by its named entry point.
+    */
+    constexpr void execute(const ALUOpcode opcode, const ALUOperands& operands) noexcept {
+        (this->*HANDLERS[static_cast<uint8_t>(opcode)])(operands);
     }
+
+private:
+    /*
+    Gate-level multiplier shared by MAC and MULH: the full 2 * ARCHITECTURE-bit product of lhs
+    and rhs, as two's complement (SIGNED) or unsigned operands. Partial products are formed
+    with AND gates, reduced to two rows by a Wallace tree of FULL_ADDER carry-save stages and
+    resolved by a ripple-carry adder.
+    */
+    template <bool SIGNED>
+    constexpr void PRODUCT(const Register& lhs, const Register& rhs, Bit (&product)[2 * ARCHITECTURE]) noexcept {
+        constexpr uint8_t WIDTH = 2 * ARCHITECTURE;
+        Bit rows[ARCHITECTURE][WIDTH] = {};
+
+        // Partial products: row j = (extended lhs << j) & rhs[j]; a signed product inverts the sign row
+        for (uint8_t j = 0; j < ARCHITECTURE; j++) {
+            const Bit negate = SIGNED && j == ARCHITECTURE - 1 ? rhs[j] : Bit(false);
+
+            for (uint8_t i = 0; i < WIDTH; i++) {
+                const Bit multiplicand = i < j || (!SIGNED && i - j >= ARCHITECTURE) ? Bit(false) : lhs[i - j < ARCHITECTURE ? i - j : ARCHITECTURE - 1];
+                rows[j][i] = multiplicand & rhs[j] ^ negate;
+            }
+        }
+
+        // Wallace tree: every group of three rows is compressed into a sum row and a carry row
+        for (uint8_t count = ARCHITECTURE; count > 2;) {
+            uint8_t in = 0, out = 0;
+
+            for (; in + 3 <= count; in += 3) {
+                Bit sum[WIDTH] = {}, carry[WIDTH] = {};
+
+                for (uint8_t i = 0; i < WIDTH; i++) {
+                    const auto [SUM, CARRY] = CombinationalCircuits::FULL_ADDER(rows[in][i], rows[in + 1][i], rows[in + 2][i]);
+                    sum[i] = SUM;
+
+                    if (i + 1 < WIDTH) {
+                        carry[i + 1] = CARRY;
+                    }
+                }
+                for (uint8_t i = 0; i < WIDTH; i++) {
+                    rows[out][i] = sum[i];
+                    rows[out + 1][i] = carry[i];
+                }
+                out += 2;
+            }
+            for (; in < count; in++, out++) {
+                for (uint8_t i = 0; i < WIDTH; i++) {
+                    rows[out][i] = rows[in][i];
+                }
+            }
+            count = out;
+        }
+
+        // Carry-propagate adder resolving the product; the carry-in completes the sign row negation
+        Bit carry = SIGNED ? rhs.MSB() : Bit(false);
+
+        for (uint8_t i = 0; i < WIDTH; i++) {
+            const auto [SUM, CARRY] = CombinationalCircuits::FULL_ADDER(rows[0][i], rows[1][i], carry);
+            product[i] = SUM;
+            carry = CARRY;
+        }
+    }
+
+    /*
+    Byte-slice ripple-carry adder: lhs = lhs + (invert ? ~rhs : rhs) + carry.
+
+    Gathers one byte of each operand at a time, adds it with a single BYTE_ADDER lookup and
+    chains the carry into the next slice. Clears ZF if any sum bit is set.
+
+    Returns:
+    - Bit: Carry out of the most significant slice.
+    */
+    constexpr Bit BYTE_SLICE_ADD(Register& lhs, const Register& rhs, const Bit invert, Bit carry) noexcept {
+        static_assert(ARCHITECTURE % 8 == 0, "byte-slice adders require a whole number of bytes");
+
+        for (uint8_t byte = 0; byte < ARCHITECTURE / 8; byte++) {
+            const uint8_t y = rhs.BYTE(byte);
+            const auto [SUM, CARRY] = CombinationalCircuits::BYTE_ADDER(lhs.BYTE(byte), invert ? static_cast<uint8_t>(~y) : y, carry);
+            lhs.SET_BYTE(byte, SUM);
+            carry = CARRY;
+
+            if (SUM) {
+                ZF = false;
+            }
+        }
+        return carry;
+    }
+
+    /*
+    Native counterpart of storing a result and comparing it against zero (CMP(reg, zero, temp)),
+    which is how the shift, rotate, NEG and DIV gate models finish:
+    reg = temp = value; ZF and SF follow value; CF = OF = 0.
+    */
+    constexpr void LOAD_RESULT(Register& reg, Register& temp, const WORD value) noexcept {
+        LSU::MOV(reg, value);
+        LSU::MOV(temp, value);
+        ZF = value == 0;
+        SF = reg.MSB();
+        CF = OF = false;
+    }
+
+    /*
+    Runs operation OP under Fidelity::CHECKED.
+
+    The operation is evaluated natively on the operand registers. When it is sampled (see
+    ALUChecker), the gate model also evaluates it on shadow copies of the operand registers,
+    starting from the same flags; aliased operands share one shadow. Registers, flags and cost
+    are then compared and a mismatch is recorded as an ALUDivergence.
+    */
+    template <ALUOpcode OP>
+    void CHECK(const ALUOperands& operands) noexcept {
+        const uint64_t operation = checker.operations++;
+
+        if (checker.sample_interval == 0 || operation % checker.sample_interval != 0) {
+            HANDLE<OP, Fidelity::NATIVE>(operands);
+            return;
+        }
+        checker.samples++;
+
+        if (!checker.shadow) {
+            checker.shadow.reset(Register::instantiate_register_set());
+        }
+        const Register* const originals[] = {operands.lhs,      operands.rhs,    operands.temp,  operands.zero,
+                                             operands.quotient, operands.acc_hi, operands.acc_lo};
+        Register* shadows[std::size(originals)] = {};
+        ALUDivergence divergence = {OP, operation, operands.count};
+        uint8_t used = 0;
+
+        for (uint8_t i = 0; i < std::size(originals); i++) {
+            if (!originals[i]) {
+                continue;
+            }
+            divergence.before[i] = static_cast<WORD>(*originals[i]);
+
+            for (uint8_t j = 0; j < i && !shadows[i]; j++) {
+                if (originals[j] == originals[i]) {
+                    shadows[i] = shadows[j];
+                }
+            }
+            if (!shadows[i]) {
+                shadows[i] = &checker.shadow[used++];
+                LSU::MOV(*shadows[i], *originals[i]);
+            }
+        }
+        ALU<Fidelity::GATE> reference;
+        reference.CF = CF;
+        reference.ZF = ZF;
+        reference.SF = SF;
+        reference.OF = OF;
+        reference.execute(OP, {shadows[0], shadows[1], shadows[2], shadows[3], shadows[4], shadows[5], shadows[6], operands.count});
+        HANDLE<OP, Fidelity::NATIVE>(operands);
+
+        for (uint8_t i = 0; i < std::size(originals); i++) {
+            if (originals[i]) {
+                divergence.gate[i] = static_cast<WORD>(*shadows[i]);
+                divergence.native[i] = static_cast<WORD>(*originals[i]);
+            }
+        }
+        divergence.gate_flags = {static_cast<bool>(reference.CF), static_cast<bool>(reference.ZF), static_cast<bool>(reference.SF),
+                                 static_cast<bool>(reference.OF)};
+        divergence.native_flags = {static_cast<bool>(CF), static_cast<bool>(ZF), static_cast<bool>(SF), static_cast<bool>(OF)};
+        divergence.gate_cost = reference.cost;
+        divergence.native_cost = cost;
+
+        if (divergence.gate != divergence.native || divergence.gate_flags != divergence.native_flags ||
+            divergence.gate_cost.cycles != divergence.native_cost.cycles || divergence.gate_cost.depth != divergence.native_cost.depth) {
+            checker.divergences.push_back(divergence);
+        }
+    }
+
+    using Handler = void (ALU::*)(const ALUOperands&) noexcept;
+
+    // Forwards a uniform operand bundle to the named operation OP evaluated with fidelity F.
+    template <ALUOpcode OP, Fidelity F = FIDELITY>
+    constexpr void HANDLE(const ALUOperands& operands) noexcept {
+        if constexpr (OP == ALUOpcode::ADD) {
+            ADD<F>(*operands.lhs, *operands.rhs);
+        } else if constexpr (OP == ALUOpcode::SUB) {
+            SUB<F>(*operands.lhs, *operands.rhs);
+        } else if constexpr (OP == ALUOpcode::MUL) {
+            MUL<F>(*operands.lhs, *operands.rhs, *operands.temp, *operands.zero);
+        } else if constexpr (OP == ALUOpcode::MAC) {
+            MAC<F>(*operands.acc_hi, *operands.acc_lo, *operands.lhs, *operands.rhs);
+        } else if constexpr (OP == ALUOpcode::DIV) {
+            DIV<F>(*operands.lhs, *operands.rhs, *operands.quotient, *operands.temp, *operands.zero);
+        } else if constexpr (OP == ALUOpcode::INC) {
+            INC<F>(*operands.lhs);
+        } else if constexpr (OP == ALUOpcode::DEC) {
+            DEC<F>(*operands.lhs);
+        } else if constexpr (OP == ALUOpcode::NEG) {
+            NEG<F>(*operands.lhs, *operands.temp, *operands.zero);
+        } else if constexpr (OP == ALUOpcode::SHL) {
+            SHL<F>(*operands.lhs, operands.count, *operands.zero, *operands.temp);
+        } else if constexpr (OP == ALUOpcode::SHR) {
+            SHR<F>(*operands.lhs, operands.count, *operands.zero, *operands.temp);
+        } else if constexpr (OP == ALUOpcode::SAR) {
+            SAR<F>(*operands.lhs, operands.count, *operands.zero, *operands.temp);
+        } else if constexpr (OP == ALUOpcode::ROL) {
+            ROL<F>(*operands.lhs, operands.count, *operands.zero, *operands.temp);
+        } else if constexpr (OP == ALUOpcode::ROR) {
+            ROR<F>(*operands.lhs, operands.count, *operands.zero, *operands.temp);
+        } else if constexpr (OP == ALUOpcode::CMP) {
+            CMP<F>(*operands.lhs, *operands.rhs, *operands.temp);
+        } else if constexpr (OP == ALUOpcode::MULH) {
+            MULH<F>(*operands.lhs, *operands.rhs);
+        }
+    }
+
+    // Handler table indexed by ALUOpcode, generated at compile time from HANDLE; defined in the
+    // class so that execute() is usable in constant expressions.
+    static constexpr std::array<Handler, static_cast<uint8_t>(ALUOpcode::COUNT)> HANDLERS =
+        []<uint8_t... OP>(std::integer_sequence<uint8_t, OP...>) {
+            return std::array<Handler, sizeof...(OP)>{&ALU::HANDLE<static_cast<ALUOpcode>(OP)>...};
+        }(std::make_integer_sequence<uint8_t, static_cast<uint8_t>(ALUOpcode::COUNT)>{});
 };
@@ -0,0 +1,120 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+Arena
+
+Bump allocator for data that lives exactly as long as one assembly unit (symbol names, fixup
+lists). Allocation is a pointer bump inside the current chunk; nothing is freed individually.
+reset() releases everything in one shot while keeping the largest chunk, so a reused Arena stops
+touching the system allocator once it has warmed up.
+
+Only trivially destructible types may be created, as no destructors are ever run.
+
+Constant evaluation:
+- The Arena is usable in constant expressions (see inline_assembler.hpp), where raw chunk bytes
+  cannot be reinterpreted as objects. There every allocation is a separate typed array, owned by
+  the Arena and deleted by reset() or the destructor.
+*/
+class Arena {
+public:
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    constexpr Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    constexpr ~Arena() { release_constant(); }
+
+    /*
+    Returns uninitialized, suitably aligned storage for `count` objects of type T.
+    */
+    template <typename T>
+    constexpr T* allocate(const size_t count = 1) {
+        static_assert(std::is_trivially_destructible_v<T>, "Arena never runs destructors");
+
+        if (std::is_constant_evaluated()) {
+            Block<T>* block = new Block<T>(count);
+            constant.push_back(block);
+            return block->data;
+        }
+        const size_t size = sizeof(T) * count;
+        size_t offset = (used + alignof(T) - 1) & ~(alignof(T) - 1);
+
+        if (chunks.empty() || offset + size > capacity) {
+            grow(size + alignof(T));
+            offset = (used + alignof(T) - 1) & ~(alignof(T) - 1);
+        }
+        used = offset + size;
+        return reinterpret_cast<T*>(chunks.back().get() + offset);
+    }
+
+    /*
+    Constructs a T in the arena.
+    */
+    template <typename T, typename... Args>
+    constexpr T* create(Args&&... args) {
+        return std::construct_at(allocate<T>(), std::forward<Args>(args)...);
+    }
+
+    /*
+    Copies `text` into the arena and returns a view of the copy.
+    */
+    constexpr std::string_view copy(const std::string_view text) {
+        char* data = allocate<char>(text.size());
+        std::copy(text.begin(), text.end(), data);
+        return {data, text.size()};
+    }
+
+    /*
+    Frees every allocation at once, keeping the largest chunk for reuse.
+    */
+    constexpr void reset() noexcept {
+        release_constant();
+
+        if (chunks.size() > 1) {
+            chunks.front().swap(chunks.back()); // The last chunk is the largest
+            chunks.resize(1);
+        }
+        used = 0;
+    }
+
+private:
+    // Owner of one constant-evaluation allocation, deleted through the base.
+    struct Allocation {
+        constexpr virtual ~Allocation() = default;
+    };
+
+    template <typename T>
+    struct Block final : Allocation {
+        T* data;
+
+        constexpr explicit Block(const size_t count) : data(new T[count]()) {}
+
+        constexpr ~Block() override { delete[] data; }
+    };
+
+    std::vector<std::unique_ptr<std::byte[]>> chunks; // The last chunk is the one being filled
+    size_t capacity = 0; // Size of the last chunk
+    size_t used = 0; // Bytes handed out from the last chunk
+    std::vector<Allocation*> constant; // Allocations made during constant evaluation
+
+    constexpr void release_constant() noexcept {
+        for (const Allocation* allocation : constant) {
+            delete allocation;
+        }
+        constant.clear();
+    }
+
+    void grow(const size_t minimum) {
+        capacity = std::max(minimum, std::max(CHUNK_SIZE, capacity * 2));
+        chunks.push_back(std::unique_ptr<std::byte[]>(new std::byte[capacity]));
+        used = 0;
+    }
+};
@@ -0,0 +1,316 @@
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "assembler.hpp"
+#include "linker.hpp"
+#include "listing.hpp"
+#include "mapped_file.hpp"
+#include "object_cache.hpp"
+#include "parallel_assembler.hpp"
+#include "thread_pool.hpp"
+
+/*
+Command-line assembler.
+
+Usage: asm <input>... [-c] [-O] [-o <output>] [-j <threads>] [--gc-sections] [--cache <directory>] [--listing <file>]
+Inputs are sources or serialized objects (recognized by OBJECT_MAGIC). Several inputs are assembled
+in parallel into relocatable objects (-j workers, default: one per hardware thread) and then linked
+in command-line order; labels starting with '.' are local to their file, all others are shared
+across files. A single source is assembled directly, or split into chunks assembled in parallel
+(ParallelAssembler) when it is large and more than one worker is available, with the same output.
+Writes the machine code to <output> (default: a.bin, `-` for standard output) and prints
+diagnostics as `<source>:<line>: error: <message>`.
+
+An input of `-` streams the source from standard input (see Assembler::begin): code is written
+as soon as it settles, so a generator can pipe an unbounded program through without a temporary
+file, and memory stays bounded by the code since the oldest pending forward reference. It is
+assembled alone and directly (no -c, --gc-sections or --cache).
+
+Options:
+- -c: write each source's object instead of linking, to <output> for a single source given -o,
+  else to the source path with its extension replaced by `.o` (appended if it has none).
+- -O: run the Peephole optimizer over every source.
+- --gc-sections: drop sections no reference from the entry section reaches (see Linker).
+- --cache: reuse the objects of unchanged sources from an ObjectCache in <directory> and store the
+  objects of the others there, so only changed sources are assembled before relinking. Sources
+  using `.incbin` are not cached: their objects depend on more than their text.
+- --listing: write a Listing of the source to <file>: address, encoding, worst-case cycles and
+  source of every line, with the cycles of every straight-line block. Only for a single source
+  assembled directly, which the option keeps from being split into parallel chunks.
+
+`.incbin` paths are relative to the working directory.
+*/
+
+static constexpr size_t STREAM_BLOCK = 1 << 20; // Bytes read from standard input at a time
+
+/*
+Streams standard input through `assembler`, writing the code to `out` as it settles.
+
+Returns:
+- false after a read error (reported) or assembly errors (left in assembler.diagnostics).
+*/
+static bool stream(Assembler& assembler, std::ostream& out) {
+    std::vector<char> buffer(STREAM_BLOCK);
+    std::vector<uint8_t> code;
+    size_t filled = 0;
+    size_t retry = 0; // A block body was cut: feed again once this much is buffered, not on every read
+    assembler.begin();
+
+    const auto write = [&] {
+        if (!code.empty()) {
+            out.write(reinterpret_cast<const char*>(code.data()), static_cast<std::streamsize>(code.size())).flush();
+            code.clear();
+        }
+    };
+    for (;;) {
+        if (filled == buffer.size()) {
+            buffer.resize(buffer.size() * 2); // A line or block longer than the buffer
+        }
+        const ssize_t count = read(STDIN_FILENO, buffer.data() + filled, buffer.size() - filled);
+
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            std::cerr << "<stdin>: error: " << std::strerror(errno) << '\n';
+            return false;
+        }
+        if (count == 0) {
+            break;
+        }
+        filled += static_cast<size_t>(count);
+        const size_t lines = std::string_view(buffer.data(), filled).find_last_of('\n') + 1; // 0 without a newline
+
+        if (!lines || filled < retry) {
+            continue;
+        }
+        const size_t consumed = assembler.feed({buffer.data(), lines}, code);
+        write();
+        std::copy(buffer.begin() + static_cast<std::ptrdiff_t>(consumed), buffer.begin() + static_cast<std::ptrdiff_t>(filled), buffer.begin());
+        filled -= consumed;
+        retry = consumed < lines ? 2 * filled : 0;
+    }
+    const bool assembled = assembler.finish({buffer.data(), filled}, code);
+    write();
+    return assembled;
+}
+
+int main(const int argc, char* argv[]) {
+    std::vector<std::string> inputs;
+    std::string output = "a.bin";
+    bool named = false; // -o was given
+    std::string cache_directory;
+    std::string listing;
+    unsigned threads = 0;
+    bool compile = false;
+    bool optimize = false;
+    bool gc_sections = false;
+    bool usage = false;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg = argv[i];
+
+        if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+            named = true;
+        } else if (arg == "-j" && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "-c") {
+            compile = true;
+        } else if (arg == "-O") {
+            optimize = true;
+        } else if (arg == "--gc-sections") {
+            gc_sections = true;
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cache_directory = argv[++i];
+        } else if (arg == "--listing" && i + 1 < argc) {
+            listing = argv[++i];
+        } else if (!arg.starts_with('-') || arg == "-") {
+            inputs.emplace_back(arg);
+        } else {
+            usage = true;
+        }
+    }
+    if (usage || inputs.empty()) {
+        std::cerr << "usage: " << argv[0] << " <input>... [-c] [-O] [-o <output>] [-j <threads>] [--gc-sections] [--cache <directory>] [--listing <file>]" << std::endl;
+        return 2;
+    }
+    std::ofstream file;
+    std::ostream& target = output == "-" ? std::cout : file;
+
+    if (std::find(inputs.begin(), inputs.end(), "-") != inputs.end()) {
+        if (inputs.size() > 1 || compile || gc_sections || !cache_directory.empty() || !listing.empty()) {
+            std::cerr << "error: standard input is assembled alone, without -c, --gc-sections, --cache or --listing" << std::endl;
+            return 2;
+        }
+        Assembler assembler;
+        assembler.optimize = optimize;
+        assembler.load_file = append_file;
+
+        if (output != "-") {
+            file.open(output, std::ios::binary);
+        }
+        const bool assembled = target && stream(assembler, target);
+
+        for (const Diagnostic& diagnostic : assembler.diagnostics) {
+            std::cerr << "<stdin>" << (diagnostic.line ? ':' + std::to_string(diagnostic.line) : "") << ": error: " << diagnostic.message << '\n';
+        }
+        if (!target) {
+            std::cerr << output << ": error: cannot write file" << std::endl;
+        }
+        return assembled && target ? 0 : 1;
+    }
+    std::optional<ObjectCache> cache;
+
+    if (!cache_directory.empty() && !cache.emplace(cache_directory)) {
+        std::cerr << cache_directory << ": error: " << std::strerror(cache->error) << std::endl;
+        return 1;
+    }
+    ThreadPool pool(threads);
+    std::vector<Assembler> assemblers(pool.size());
+
+    for (Assembler& assembler : assemblers) {
+        assembler.optimize = optimize;
+        assembler.load_file = append_file;
+    }
+    const std::string_view environment = optimize ? "-O" : ""; // Assembler options the cached objects depend on
+    std::vector<Object> objects(inputs.size());
+    std::vector<std::vector<Diagnostic>> diagnostics(inputs.size());
+    std::vector<int> errnos(inputs.size());
+    std::vector<bool> sources(inputs.size()); // Inputs assembled here rather than read as objects
+    std::vector<uint8_t> image;
+    const bool direct = inputs.size() == 1 && !compile && !gc_sections && !cache;
+    bool listed = false; // The listing was written
+
+    if (!listing.empty() && !direct) {
+        std::cerr << "error: --listing takes a single source, without -c, --gc-sections or --cache" << std::endl;
+        return 2;
+    }
+
+    // Reads input i into objects[i], assembling it on `worker` unless it is an object already
+    const auto load = [&](const size_t i, const unsigned worker) {
+        const MappedFile input(inputs[i].c_str());
+        errnos[i] = input.error;
+
+        if (!input) {
+            return;
+        }
+        objects[i].name = inputs[i];
+        sources[i] = !input.view().starts_with(OBJECT_MAGIC);
+        size_t included = 0; // Files the source read with .incbin
+
+        if (!sources[i]) {
+            if (!read_object(input.view(), objects[i])) {
+                diagnostics[i].push_back({0, "malformed object file"});
+            }
+        } else if (cache && cache->load(input.view(), environment, objects[i])) {
+            return;
+        } else if (inputs.size() == 1 && pool.size() > 1 && input.view().size() >= 2 * ParallelAssembler::MIN_CHUNK && listing.empty()) {
+            ParallelAssembler assembler(pool);
+            assembler.optimize = optimize;
+            assembler.load_file = append_file;
+
+            if (direct) {
+                assembler.assemble(input.view());
+                image.swap(assembler.code);
+                objects.clear();
+            } else {
+                assembler.assemble(input.view(), objects[i]);
+            }
+            diagnostics[i].swap(assembler.diagnostics);
+            included = assembler.included;
+        } else if (direct) {
+            assemblers[worker].list = !listing.empty();
+            assemblers[worker].assemble(input.view());
+
+            if (assemblers[worker].list && assemblers[worker].diagnostics.empty()) {
+                std::ofstream out(listing);
+                Listing::write(out, input.view(), assemblers[worker].code, assemblers[worker].origins);
+                listed = static_cast<bool>(out.flush());
+            }
+            image.swap(assemblers[worker].code);
+            diagnostics[i].swap(assemblers[worker].diagnostics);
+            objects.clear();
+        } else {
+            assemblers[worker].assemble(input.view(), objects[i]);
+            diagnostics[i].swap(assemblers[worker].diagnostics);
+            included = assemblers[worker].included;
+        }
+        if (cache && sources[i] && diagnostics[i].empty() && !included) {
+            cache->store(input.view(), environment, objects[i]);
+        }
+    };
+    if (inputs.size() == 1) {
+        load(0, 0);
+    } else {
+        pool.parallel_for(inputs.size(), load);
+    }
+    bool failed = false;
+
+    for (size_t i = 0; i < inputs.size(); i++) {
+        if (errnos[i]) {
+            std::cerr << inputs[i] << ": error: " << std::strerror(errnos[i]) << '\n';
+        }
+        for (const Diagnostic& diagnostic : diagnostics[i]) {
+            std::cerr << inputs[i] << (diagnostic.line ? ':' + std::to_string(diagnostic.line) : "") << ": error: " << diagnostic.message << '\n';
+        }
+        failed |= errnos[i] || !diagnostics[i].empty();
+    }
+    if (failed) {
+        return 1;
+    }
+    if (!listing.empty() && !listed) {
+        std::cerr << listing << ": error: " << (sources[0] ? "cannot write file" : "an object has no source to list") << std::endl;
+        return 1;
+    }
+    if (compile) {
+        for (size_t i = 0; i < inputs.size(); i++) {
+            if (!sources[i]) {
+                continue;
+            }
+            const size_t name = inputs[i].find_last_of('/') + 1;
+            const size_t extension = inputs[i].find_last_of('.');
+            const std::string stem = extension != std::string::npos && extension >= name ? inputs[i].substr(0, extension) : inputs[i];
+            const std::string path = inputs.size() == 1 && named ? output : stem + ".o";
+            image.clear();
+            write_object(objects[i], image);
+            std::ofstream out(path, std::ios::binary);
+            out.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+
+            if (!out) {
+                std::cerr << path << ": error: cannot write file" << std::endl;
+                return 1;
+            }
+        }
+        return 0;
+    }
+    if (!objects.empty()) {
+        Linker linker;
+
+        if (!linker.link(objects, gc_sections)) {
+            for (const std::string& error : linker.errors) {
+                std::cerr << "error: " << error << '\n';
+            }
+            return 1;
+        }
+        image.swap(linker.image);
+    }
+    if (output != "-") {
+        file.open(output, std::ios::binary);
+    }
+    target.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+
+    if (!target.flush()) {
+        std::cerr << output << ": error: cannot write file" << std::endl;
+        return 1;
+    }
+    return 0;
+}
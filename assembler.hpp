@@ -0,0 +1,2248 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "arena.hpp"
+#include "interner.hpp"
+#include "isa.hpp"
+#include "lexer.hpp"
+#include "object.hpp"
+#include "peephole.hpp"
+#include "perfect_hash.hpp"
+
+/*
+An assembly error, reported against the source line it was found on.
+*/
+struct Diagnostic {
+    uint32_t line;
+    std::string message;
+};
+
+/*
+The outcome of assembling one source in memory: views of the Assembler's own buffers, valid until
+it assembles again.
+*/
+struct Program {
+    std::span<const uint8_t> code; // Encoded machine code
+    std::span<const Diagnostic> diagnostics; // Errors, in line order
+
+    // Whether the source assembled without errors.
+    explicit constexpr operator bool() const noexcept { return diagnostics.empty(); }
+};
+
+/*
+A reserved assembly name: a mnemonic (value is its Opcode) or a register name (value is its index).
+*/
+struct Keyword {
+    enum class Kind : uint8_t { MNEMONIC, REGISTER } kind;
+    uint8_t value;
+};
+
+// Every mnemonic and register name (r0-r15, zero, temp), looked up with one hash and one compare.
+inline constexpr auto KEYWORDS = [] {
+    constexpr std::string_view REGISTER_NAMES[] = {"r0", "r1", "r2",  "r3",  "r4",  "r5",  "r6",  "r7",   "r8",  "r9",
+                                                   "r10", "r11", "r12", "r13", "r14", "r15", "zero", "temp"};
+    constexpr uint8_t REGISTER_VALUES[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, ZERO_REGISTER, TEMP_REGISTER};
+    // Opcodes sharing a mnemonic are adjacent (MOV_RR/MOV_RI, long/short branches); the first one is the keyword
+    constexpr auto SHARED = [](const uint8_t i) { return i > 0 && OPCODES[i].mnemonic == OPCODES[i - 1].mnemonic; };
+    constexpr size_t MNEMONIC_COUNT = [&] {
+        size_t count = 0;
+
+        for (uint8_t i = 0; i < OPCODES.size(); i++) {
+            count += !SHARED(i);
+        }
+        return count;
+    }();
+    std::array<std::pair<std::string_view, Keyword>, MNEMONIC_COUNT + std::size(REGISTER_NAMES)> entries{};
+    size_t count = 0;
+
+    for (uint8_t i = 0; i < OPCODES.size(); i++) {
+        if (!SHARED(i)) {
+            entries[count++] = {OPCODES[i].mnemonic, {Keyword::Kind::MNEMONIC, i}};
+        }
+    }
+    for (uint8_t i = 0; i < std::size(REGISTER_NAMES); i++) {
+        entries[count++] = {REGISTER_NAMES[i], {Keyword::Kind::REGISTER, REGISTER_VALUES[i]}};
+    }
+    return PerfectHash<Keyword, entries.size()>(entries);
+}();
+
+static_assert(KEYWORDS.valid(), "mnemonics and register names must be unique and at most 4 characters");
+
+/*
+Reads a file for `.incbin`: appends the contents of the file at `path` to `out` (see append_file
+in mapped_file.hpp).
+
+Returns:
+- an empty string on success, else the reason the file could not be read.
+*/
+using FileLoader = std::string (*)(std::string_view path, std::vector<uint8_t>& out);
+
+/*
+Assembler
+
+Translates assembly source into the machine encoding described in isa.hpp, in a single pass.
+Follows separation of concerns (SOC): the Lexer tokenizes, the Assembler parses, and operands are
+checked against and encoded by the format tables of isa.hpp (FORMATS, encode).
+
+- One statement per line: label definitions (`name:`) followed by an optional instruction or
+  directive. Mnemonics and register names are case-insensitive and reserved (see KEYWORDS);
+  operands are described at operand(), directives at directive().
+- Output is direct (`code`), relocatable (an Object for the Linker), or streamed (see begin()).
+- Errors are reported as diagnostics rather than exceptions; the rest of the offending line is
+  skipped and assembly continues so one run reports every error.
+- No global state and no I/O (.incbin goes through `load_file`), and every step is constexpr, so
+  a source can be assembled inside a constant expression (see the `_asm` literal in
+  inline_assembler.hpp).
+*/
+class Assembler {
+public:
+    std::vector<uint8_t> code; // Encoded machine code of the last assembled source
+    std::vector<Diagnostic> diagnostics; // Errors of the last assembled source, in line order
+    bool optimize = false; // Run the Peephole pass
+    FileLoader load_file = nullptr; // Reads `.incbin` files; without one, .incbin is an error
+    bool list = false; // Trace `origins` (direct output of assemble(source) only)
+    std::vector<Origin> origins; // Where the last assembled source's code came from, in code order (see trace)
+    size_t included = 0; // Files the last assembled source read with .incbin
+
+    /*
+    Assembles `source` into `code`, replacing the output of any previous run.
+    `source` only has to stay alive for the duration of the call. A reused Assembler keeps the
+    capacity of its buffers (see release()), so assembling many generated programs in a loop
+    allocates next to nothing once warm.
+
+    Returns:
+    - the Program: `code` and `diagnostics`, true when the source assembled without errors.
+    */
+    constexpr Program assemble(const std::string_view source) {
+        run(source, nullptr);
+        return {code, diagnostics};
+    }
+
+    /*
+    Assembles `source` into the relocatable `object` instead of `code` (object.name is kept): every
+    label reference becomes a Relocation, and undefined global labels are left for the Linker.
+    Only undefined file-local labels ('.' prefix) are errors. Code before the first `.section` is
+    in `.text`.
+
+    Returns:
+    - true when the source assembled without errors.
+    */
+    constexpr bool assemble(const std::string_view source, Object& object) {
+        RESET(object);
+        return run(source, &object);
+    }
+
+    /*
+    Assembles `source` as one piece of a larger source for assemble(pieces) (see ParallelAssembler):
+    the code is parsed and encoded, but nothing is settled, and labels the piece does not define are
+    not errors. Lines are counted from 1 within the piece.
+
+    Parameters:
+    - relocatable: the pieces are for assemble(pieces, object); code before the first `.section`
+      continues the section of the piece before.
+    */
+    constexpr void assemble_piece(const std::string_view source, const bool relocatable) {
+        partial.sections.assign(1, {"", 0, 0});
+        partial.relocations.clear();
+        start(relocatable ? &partial : nullptr);
+        piece = true;
+        parse(source);
+        flush();
+        partial.sections.back().size = static_cast<uint32_t>(code.size()) - partial.sections.back().offset;
+    }
+
+    /*
+    Assembles the source whose consecutive pieces `pieces` hold (see assemble_piece) into `code`,
+    exactly as assemble(source) would: the pieces are joined in order into one unit, whose label
+    references, branches, paddings and expressions are then settled over the whole.
+
+    Returns:
+    - the Program: `code` and `diagnostics`, true when the source assembled without errors.
+    */
+    constexpr Program assemble(const std::span<const Assembler> pieces) {
+        start(nullptr);
+        join(pieces);
+        backpatch();
+        complete();
+        return {code, diagnostics};
+    }
+
+    /*
+    Assembles the source whose consecutive relocatable pieces `pieces` hold (see assemble_piece)
+    into the relocatable `object`, exactly as assemble(source, object) would.
+
+    Returns:
+    - true when the source assembled without errors.
+    */
+    constexpr bool assemble(const std::span<const Assembler> pieces, Object& object) {
+        RESET(object);
+        start(&object);
+        join(pieces);
+        return complete();
+    }
+
+    /*
+    Starts assembling a source that arrives in pieces of complete lines, such as from a pipe, into
+    direct output: feed() every piece in order, then finish() with the rest. Whenever a piece leaves
+    no referenced label undefined, the code so far is final and is passed on, keeping only the
+    label table, so memory is bounded by the code since the oldest pending forward reference. The
+    code is the same as assemble() of the whole source.
+    */
+    constexpr void begin() {
+        start(nullptr);
+        streaming = true;
+    }
+
+    /*
+    Assembles `piece`, complete lines that continue the source, and moves the code that has
+    settled to the end of `out`.
+
+    Returns:
+    - the number of bytes of `piece` consumed: all of it, unless it ends inside a .macro, .rept or
+      .irp body. The rest has to be passed again, followed by more of the source.
+    */
+    constexpr size_t feed(const std::string_view piece, std::vector<uint8_t>& out) {
+        parse(piece);
+        size_t consumed = piece.size();
+
+        if (incomplete) {
+            consumed = static_cast<size_t>(opened.text - piece.data());
+            next_line = opened.line;
+            diagnostics.resize(opened.diagnostics);
+            recorded.resize(opened.recorded);
+            parameters.resize(opened.parameters);
+            incomplete = false;
+        }
+        if (!undefined) {
+            settle(out);
+        }
+        return consumed;
+    }
+
+    /*
+    Assembles `rest`, the end of a source started with begin(), and moves the remaining code to the
+    end of `out`.
+
+    Returns:
+    - true when the whole source assembled without errors; `out` is not complete otherwise.
+    */
+    constexpr bool finish(const std::string_view rest, std::vector<uint8_t>& out) {
+        streaming = false;
+        parse(rest);
+
+        if (!complete()) {
+            return false;
+        }
+        out.insert(out.end(), code.begin(), code.end());
+        code.clear();
+        return true;
+    }
+
+private:
+    static constexpr uint32_t ADDRESS_SPACE = 1u << ARCHITECTURE;
+    static constexpr uint32_t MAX_DEPTH = 64; // Nested expansions, which bounds macro recursion
+
+    constexpr bool run(const std::string_view source, Object* const output) {
+        start(output);
+        parse(source);
+        return complete();
+    }
+
+    // Empties `object` for a new unit, keeping its name.
+    static constexpr void RESET(Object& object) {
+        object.code.clear();
+        object.sections.assign(1, {".text", 0, 0});
+        object.symbols.clear();
+        object.relocations.clear();
+    }
+
+    // Resets the state of the previous unit for one written to `output` (nullptr: `code`).
+    constexpr void start(Object* const output) {
+        code.clear();
+        diagnostics.clear();
+        included = 0;
+        release();
+        object = output;
+        piece = false;
+        base = 0;
+        next_line = 1;
+        origins.clear();
+        peephole.origins = list ? &origins : nullptr;
+    }
+
+    // Assembles `source`, which continues the unit from line `next_line` on.
+    constexpr void parse(const std::string_view source) {
+        lexer = Lexer(source, next_line);
+        advance();
+
+        while (token.kind != TokenKind::END) {
+            if (list) {
+                peephole.line = token.line;
+
+                if (!optimize) {
+                    trace();
+                }
+            }
+            if (!statement()) {
+                while (token.kind != TokenKind::NEWLINE && token.kind != TokenKind::END) {
+                    advance();
+                }
+            }
+            if (token.kind == TokenKind::NEWLINE) {
+                advance();
+            }
+            bound();
+        }
+        next_line = token.line;
+    }
+
+    /*
+    Ends the unit: reports undefined labels, settles branches, paddings and expressions, and
+    writes the relocatable output.
+    */
+    constexpr bool complete() {
+        flush();
+        const size_t parsed = diagnostics.size();
+
+        for (uint32_t id = 0; id < symbols.size(); id++) {
+            if (!symbols[id].defined && (!object || labels.name(id)[0] == '.')) {
+                error(symbols[id].line, "undefined label '" + std::string(labels.name(id)) + "'");
+            }
+        }
+        merge_diagnostics(parsed); // Parse errors as found, undefined labels by first reference (ID order)
+
+        if (diagnostics.empty() && (!branches.empty() || !aligns.empty())) {
+            relax();
+        }
+        if (diagnostics.empty() && !expressions.empty()) {
+            resolve();
+        }
+
+        if (object) {
+            object->sections.back().size = static_cast<uint32_t>(code.size()) - object->sections.back().offset;
+            object->code.swap(code);
+            object->symbols.resize(symbols.size());
+
+            for (uint32_t id = 0; id < symbols.size(); id++) {
+                object->symbols[id] = {std::string(labels.name(id)), symbols[id].address, symbols[id].section, symbols[id].line, symbols[id].defined,
+                                       labels.name(id)[0] != '.'};
+            }
+            object = nullptr;
+        }
+        release();
+        return diagnostics.empty();
+    }
+
+    /*
+    A pending imm16 field waiting for a label's address; fixups of one label form an arena-allocated list.
+    */
+    struct Fixup {
+        uint32_t offset; // Offset of the imm16 field in `code`
+        Fixup* next;
+    };
+
+    /*
+    A label: its address once defined, otherwise the fixups waiting for it.
+    */
+    struct Symbol {
+        uint32_t address = 0;
+        uint32_t section = 0; // Index of the defining section in relocatable output
+        bool defined = false;
+        uint32_t line = 0; // Line of the definition, else of the first reference
+        Fixup* fixups = nullptr;
+    };
+
+    /*
+    A branch to a label, emitted in its short form until relax() settles its encoding.
+    */
+    struct Branch {
+        uint32_t offset; // Offset of the branch in `code` as emitted (every branch short)
+        uint32_t label; // Target label ID
+        uint32_t section; // Section of the branch in relocatable output
+        uint32_t line;
+        Opcode opcode; // Long form
+        bool grown = false; // Needs the long form
+    };
+
+    /*
+    An `.align`: emitted as alignment - 1 fill bytes, of which relax() keeps as many as the final
+    layout needs.
+    */
+    struct Align {
+        uint32_t offset; // Offset of the reserved padding in `code` as emitted
+        uint32_t alignment;
+        uint32_t section; // Section of the directive in relocatable output, which it aligns within
+        uint8_t fill;
+    };
+
+    /*
+    A label's imm16 in `code` (direct output), repatched by relax() when the layout shifts.
+    */
+    struct Reference {
+        uint32_t offset; // Offset of the imm16 field in `code`
+        uint32_t label;
+        uint32_t line;
+    };
+
+    /*
+    One step of an expression in postfix form: pushes a number or label, or applies an operator
+    to the values on top of the evaluation stack.
+    */
+    struct Term {
+        enum class Kind : uint8_t { NUMBER, LABEL, NEGATE, NOT, MULTIPLY, DIVIDE, REMAINDER, ADD, SUBTRACT, SHIFT_LEFT, SHIFT_RIGHT, AND, XOR, OR } kind;
+        int64_t value = 0; // Number, or label ID of a LABEL once the expression is recorded
+        std::string_view name = {}; // Label name of a LABEL
+    };
+
+    /*
+    A parsed instruction operand.
+    */
+    struct Operand {
+        enum class Kind : uint8_t { REGISTER, IMMEDIATE, SYMBOL, EXPRESSION } kind = Kind::IMMEDIATE;
+        int64_t value = 0; // Register index, immediate value, or index of an EXPRESSION in `expressions`
+        std::string_view name; // Label name of a SYMBOL operand
+    };
+
+    /*
+    An imm16 field holding an expression over labels, evaluated by resolve().
+    */
+    struct Expression {
+        Term* terms; // Arena-allocated postfix form
+        uint32_t count;
+        uint32_t line;
+        uint32_t offset = 0; // Offset of the imm16 field in `code` as emitted, once encoded
+    };
+
+    /*
+    An evaluated expression: constant + weight * (address of label). The weight is 0 except in
+    relocatable output, where label addresses are only known relative to their section.
+    */
+    struct Value {
+        int64_t constant = 0;
+        int64_t weight = 0;
+        uint32_t label = 0;
+    };
+
+    /*
+    A token of a recorded body or an expansion.
+    */
+    struct RecordedToken {
+        Token token;
+        bool joined = false; // No blank before it, so a substitution next to it pastes (see substitute)
+    };
+
+    /*
+    Tokens [begin, end) of `recorded`.
+    */
+    struct Range {
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    /*
+    A `.macro`: its recorded body and parameter names.
+    */
+    struct Macro {
+        Range body;
+        uint32_t parameters; // First name in `parameters`
+        uint32_t count;
+    };
+
+    /*
+    A body replayed in place of the source: an expansion once, a .rept body `repeats` times.
+    */
+    struct Frame {
+        uint32_t next; // Next token in `recorded`
+        Range body;
+        uint32_t line; // Line of the invocation, carried by every replayed token
+        uint32_t repeats;
+    };
+
+    /*
+    Start of the block directive last read from the source, given back by feed() when the piece
+    ends inside its body.
+    */
+    struct Checkpoint {
+        const char* text = nullptr; // The directive in the piece
+        uint32_t line = 0;
+        size_t diagnostics = 0; // Sizes to restore
+        size_t recorded = 0;
+        size_t parameters = 0;
+    };
+
+    Lexer lexer{{}};
+    Token token;
+    Object* object = nullptr; // Relocatable output of the current run, if any
+    bool piece = false; // The unit is a piece of a larger source (see assemble_piece)
+    Object partial; // Sections and relocations of a piece
+    Arena arena; // Per-unit storage: names and pasted tokens
+    Arena scratch; // Fixups and expression terms, which live until the code they patch settles
+    Interner labels{arena}; // Label name -> dense label ID
+    std::vector<Symbol> symbols; // Indexed by label ID
+    /*
+    End of a segment of the code (see relax()): the branches and aligns emitted before it.
+    */
+    struct Boundary {
+        uint32_t branches = 0;
+        uint32_t aligns = 0;
+    };
+
+    /*
+    A step of a piece that join() replays, so undefined labels and segment ends come out as if the
+    unit had parsed the piece itself.
+    */
+    struct Event {
+        enum class Kind : uint8_t { LABEL, DEFINE, BOUND } kind; // First use of a label, its definition, or the end of a statement
+        uint32_t label = 0; // Label ID of a LABEL or DEFINE
+        Boundary end = {}; // Branches and aligns before a BOUND
+    };
+
+    uint32_t undefined = 0; // Symbols not defined (yet)
+    std::vector<Event> events; // Of a piece, in source order
+    std::vector<uint32_t> placed; // Labels defined since the code last settled
+    uint32_t base = 0; // Code passed on by feed(): bytes before code[0]
+    uint32_t next_line = 1; // Line the next piece starts on
+    bool streaming = false; // Between begin() and finish()
+    bool incomplete = false; // The piece ended inside a block body (see `opened`)
+    Checkpoint opened;
+    std::vector<Branch> branches; // In code order
+    std::vector<Reference> references; // In code order
+    std::vector<Expression> expressions; // Expressions over labels, in source order
+    std::vector<Term> terms; // Postfix form of the expression being parsed
+    std::vector<Value> values; // Evaluation stack
+    std::vector<uint32_t> growth; // Fenwick tree over `branches`: 1 per grown branch
+    std::vector<Align> aligns; // In code order
+    std::vector<uint32_t> trimmed; // Reserved padding bytes the aligns before index k drop in the current layout
+    std::vector<Boundary> boundaries; // Segment ends, in code order
+    std::vector<uint32_t> worklist; // Short branches relax() re-checks
+    std::vector<uint8_t> relaxed; // Code laid out again by relax(), swapped with `code`
+    Peephole peephole; // Window of instructions not yet in `code` (optimize only)
+    std::vector<RecordedToken> recorded; // Bodies and expansions, replayed by `frames`
+    std::vector<Frame> frames; // Innermost last; empty while reading the source itself
+    Interner macro_names{arena}; // Macro name -> index in `macros`
+    std::vector<Macro> macros;
+    std::vector<std::string_view> parameters; // Parameter names of every macro
+    Interner expansion_keys{arena}; // Body and argument text -> index in `expansions`
+    std::vector<Range> expansions; // Memoized expansions in `recorded`
+    std::vector<RecordedToken> arguments; // Arguments of the invocation being expanded
+    std::vector<uint32_t> bounds; // Argument k is arguments[bounds[k], bounds[k + 1])
+    std::string key; // Memoization key being built
+
+    /*
+    Returns the ID of label `name`, creating its symbol on first use.
+    */
+    constexpr uint32_t label_id(const std::string_view name) {
+        const uint32_t id = labels.intern(name);
+
+        if (id == symbols.size()) {
+            symbols.emplace_back();
+            undefined++;
+
+            if (piece) {
+                events.push_back({Event::Kind::LABEL, id});
+            }
+        }
+        return id;
+    }
+
+    /*
+    Frees all per-unit state in one shot, keeping the capacity for the next unit: label names live
+    in `arena`, fixups and expression terms in `scratch`, so nothing is freed symbol by symbol.
+    */
+    constexpr void release() noexcept {
+        symbols.clear();
+        undefined = 0;
+        placed.clear();
+        branches.clear();
+        references.clear();
+        expressions.clear();
+        aligns.clear();
+        boundaries.clear();
+        events.clear();
+        recorded.clear();
+        frames.clear();
+        macros.clear();
+        parameters.clear();
+        expansions.clear();
+        labels.clear();
+        macro_names.clear();
+        expansion_keys.clear();
+        arena.reset();
+        scratch.reset();
+    }
+
+    /*
+    Settles the code assembled since the last call, which references no undefined label, and moves
+    it to the end of `out` (see begin()).
+    */
+    constexpr void settle(std::vector<uint8_t>& out) {
+        if (diagnostics.empty() && (!branches.empty() || !aligns.empty())) {
+            relax();
+        }
+        if (diagnostics.empty() && !expressions.empty()) {
+            resolve();
+        }
+        base += static_cast<uint32_t>(code.size());
+
+        if (diagnostics.empty() && out.empty()) {
+            out.swap(code);
+        } else if (diagnostics.empty()) {
+            out.insert(out.end(), code.begin(), code.end());
+        }
+        code.clear();
+        branches.clear();
+        references.clear();
+        expressions.clear();
+        aligns.clear();
+        boundaries.clear();
+        placed.clear();
+        scratch.reset();
+    }
+
+    // Ends a segment after the statement just assembled; a piece leaves that to join().
+    constexpr void bound() {
+        const Boundary end = {static_cast<uint32_t>(branches.size()), static_cast<uint32_t>(aligns.size())};
+
+        if (!piece) {
+            bound(end);
+        } else if (events.empty() || events.back().kind != Event::Kind::BOUND || events.back().end.branches != end.branches ||
+                   events.back().end.aligns != end.aligns) {
+            events.push_back({Event::Kind::BOUND, 0, end});
+        }
+    }
+
+    // Ends a segment at `end` if no label is undefined and the segment holds a branch or align.
+    constexpr void bound(const Boundary end) {
+        const Boundary last = boundaries.empty() ? Boundary{} : boundaries.back();
+
+        if (!undefined && (end.branches > last.branches || end.aligns > last.aligns)) {
+            boundaries.push_back(end);
+        }
+    }
+
+    // Appends every piece to the unit in turn.
+    constexpr void join(const std::span<const Assembler> pieces) {
+        size_t size = 0;
+
+        for (const Assembler& piece : pieces) {
+            size += piece.code.size();
+        }
+        code.reserve(size);
+
+        for (const Assembler& piece : pieces) {
+            join(piece);
+        }
+    }
+
+    /*
+    Appends `piece` (see assemble_piece) to the unit: its code, labels, branches, aligns, label
+    references, expressions and relocations move behind the code so far, its label IDs and sections map to the
+    unit's and its lines count on from the lines so far.
+    */
+    constexpr void join(const Assembler& piece) {
+        const uint32_t offset = here();
+        const uint32_t lines = next_line - 1;
+        const uint32_t first_branch = static_cast<uint32_t>(branches.size());
+        const uint32_t first_align = static_cast<uint32_t>(aligns.size());
+        std::vector<uint32_t> ids(piece.symbols.size()); // Piece label ID -> unit label ID
+        std::vector<uint32_t> sections(object ? piece.partial.sections.size() : 0); // Piece section -> unit section (relocatable output)
+
+        for (size_t s = 0; s < sections.size(); s++) {
+            const Section& section = piece.partial.sections[s];
+            Section& current = object->sections.back();
+
+            if (s) {
+                current.size = offset + section.offset - current.offset; // As `.section` in the unit would
+
+                if (current.size) {
+                    object->sections.push_back({section.name, offset + section.offset, 0});
+                } else {
+                    current.name = section.name;
+                }
+            }
+            object->sections.back().alignment = std::max(object->sections.back().alignment, section.alignment);
+            sections[s] = static_cast<uint32_t>(object->sections.size() - 1);
+        }
+        for (const Diagnostic& diagnostic : piece.diagnostics) {
+            error(diagnostic.line + lines, std::string(diagnostic.message));
+        }
+        const size_t parsed = diagnostics.size();
+
+        for (const Event& event : piece.events) {
+            if (event.kind == Event::Kind::BOUND) {
+                bound({first_branch + event.end.branches, first_align + event.end.aligns});
+                continue;
+            }
+            const Symbol& from = piece.symbols[event.label];
+
+            if (event.kind == Event::Kind::LABEL) {
+                ids[event.label] = label_id(piece.labels.name(event.label));
+                symbols[ids[event.label]].line = symbols[ids[event.label]].line ? symbols[ids[event.label]].line : from.line + lines;
+                continue;
+            }
+            Symbol& label = symbols[ids[event.label]];
+
+            if (label.defined) {
+                error(from.line + lines, "duplicate label '" + std::string(labels.name(ids[event.label])) + "'");
+                continue;
+            }
+            label.defined = true;
+            label.line = from.line + lines;
+            label.section = object ? sections[from.section] : 0;
+            label.address = offset + from.address;
+            undefined--;
+            placed.push_back(ids[event.label]);
+        }
+        merge_diagnostics(parsed);
+
+        for (const Branch& branch : piece.branches) {
+            branches.push_back({offset + branch.offset, ids[branch.label], object ? sections[branch.section] : 0, branch.line + lines, branch.opcode});
+        }
+        for (const Align& align : piece.aligns) {
+            aligns.push_back({offset + align.offset, align.alignment, object ? sections[align.section] : 0, align.fill});
+        }
+        for (const Reference& reference : piece.references) {
+            references.push_back({offset + reference.offset, ids[reference.label], reference.line + lines});
+        }
+        for (size_t i = 0; i < (object ? piece.partial.relocations.size() : 0); i++) {
+            object->relocations.push_back({offset + piece.partial.relocations[i].offset, ids[piece.partial.relocations[i].symbol]});
+        }
+        // A piece with errors may hold expressions it never encoded, and the unit does not settle anyway
+        for (size_t i = 0; i < (piece.diagnostics.empty() ? piece.expressions.size() : 0); i++) {
+            const Expression& expression = piece.expressions[i];
+            Term* const copy = scratch.allocate<Term>(expression.count);
+            std::copy(expression.terms, expression.terms + expression.count, copy);
+
+            for (Term* term = copy; term != copy + expression.count; term++) {
+                term->value = term->kind == Term::Kind::LABEL ? ids[term->value] : term->value;
+            }
+            expressions.push_back({copy, expression.count, expression.line + lines, offset + expression.offset});
+        }
+        code.insert(code.end(), piece.code.begin(), piece.code.end());
+        included += piece.included;
+        next_line += piece.next_line - 1;
+    }
+
+    /*
+    Patches the label references of the joined pieces (direct output). A label beyond the address
+    space is reported where the whole source would report it: at a reference after its definition,
+    else once at the definition.
+    */
+    constexpr void backpatch() {
+        const size_t found = diagnostics.size();
+        std::vector<bool> reported; // Indexed by label ID, once a label is reported at its definition
+
+        for (const Reference& reference : references) {
+            const Symbol& label = symbols[reference.label];
+
+            if (!label.defined) {
+                continue; // Reported by complete()
+            }
+            if (label.address < ADDRESS_SPACE) {
+                patch_word(reference.offset, static_cast<uint16_t>(label.address));
+            } else if (label.address <= reference.offset) {
+                error(reference.line, "label '" + std::string(labels.name(reference.label)) + "' lies beyond the " + to_decimal(ARCHITECTURE) + "-bit address space");
+            } else {
+                reported.resize(symbols.size());
+
+                if (!reported[reference.label]) {
+                    reported[reference.label] = true;
+                    error(label.line, "label '" + std::string(labels.name(reference.label)) + "' lies beyond the " + to_decimal(ARCHITECTURE) + "-bit address space");
+                }
+            }
+        }
+        std::sort(diagnostics.begin() + static_cast<std::ptrdiff_t>(found), diagnostics.end(), [](const Diagnostic& a, const Diagnostic& b) { return a.line < b.line; });
+        merge_diagnostics(found);
+    }
+
+    // `token` kept beyond the current piece: while streaming, a piece read from the source only lives for its feed().
+    constexpr Token kept(Token token) {
+        if (streaming && frames.empty()) {
+            token.text = arena.copy(token.text);
+        }
+        return token;
+    }
+
+    // Offset of the next byte of code, counting the code already passed on.
+    constexpr uint32_t here() const noexcept { return base + static_cast<uint32_t>(code.size()); }
+
+    constexpr void advance() noexcept {
+        if (frames.empty()) {
+            token = lexer.next();
+        } else {
+            replay();
+        }
+    }
+
+    // Takes the next token from the innermost frame, dropping the exhausted ones.
+    constexpr void replay() noexcept {
+        while (!frames.empty()) {
+            Frame& frame = frames.back();
+
+            if (frame.next == frame.body.end && frame.repeats > 1) {
+                frame.repeats--;
+                frame.next = frame.body.begin;
+            }
+            if (frame.next < frame.body.end) {
+                token = recorded[frame.next++].token;
+                token.line = frame.line;
+                return;
+            }
+            frames.pop_back();
+        }
+        token = lexer.next();
+    }
+
+    // Whether the current token follows `previous` without a blank (see RecordedToken).
+    constexpr bool joined(const Token& previous) const noexcept {
+        return frames.empty() ? previous.text.data() + previous.text.size() == token.text.data() : recorded[frames.back().next - 1].joined;
+    }
+
+    // Moves the Peephole window into `code`, before anything records an offset in it.
+    constexpr void flush() {
+        if (optimize) {
+            peephole.flush(code);
+        }
+        if (list) {
+            trace();
+        }
+    }
+
+    /*
+    Traces the code from here on to the line of the current statement, when `list` is set, into
+    `origins` for Listing (listing.hpp). Inside an expansion the line is the outermost invocation's,
+    and with `optimize` the Peephole traces every instruction it holds or rewrites.
+    */
+    constexpr void trace(const bool data = false, const bool entry = false) { Origin::trace(origins, {peephole.line, here(), data, entry}); }
+
+    constexpr void error(const uint32_t line, std::string&& message) { diagnostics.push_back({line, std::move(message)}); }
+
+    /*
+    Merges the diagnostics reported from `boundary` on into the earlier ones; both runs must be in line order.
+    */
+    constexpr void merge_diagnostics(const size_t boundary) {
+        if (boundary && boundary < diagnostics.size()) {
+            std::vector<Diagnostic> merged(diagnostics.size());
+            std::merge(std::make_move_iterator(diagnostics.begin()), std::make_move_iterator(diagnostics.begin() + boundary),
+                       std::make_move_iterator(diagnostics.begin() + boundary), std::make_move_iterator(diagnostics.end()), merged.begin(),
+                       [](const Diagnostic& a, const Diagnostic& b) { return a.line < b.line; });
+            diagnostics.swap(merged);
+        }
+    }
+
+    constexpr bool fail(std::string&& message) {
+        error(token.line, std::move(message));
+        return false;
+    }
+
+    constexpr bool expect(const char punctuator) {
+        if (token.kind != TokenKind::PUNCTUATOR || token.text[0] != punctuator) {
+            return fail(std::string("expected '") + punctuator + "'");
+        }
+        advance();
+        return true;
+    }
+
+    /*
+    Parses one line: any number of label definitions followed by an optional instruction.
+    Returns false after reporting an error; the caller skips the rest of the line.
+    */
+    constexpr bool statement() {
+        while (token.kind == TokenKind::IDENTIFIER) {
+            const Token name = token;
+            advance();
+
+            if (token.kind == TokenKind::PUNCTUATOR && token.text[0] == ':') {
+                advance();
+
+                if (!define(name)) {
+                    return false;
+                }
+            } else if (name.text[0] == '.') {
+                return directive(name);
+            } else if (const uint32_t macro = macros.empty() ? Interner::NONE : macro_names.find(name.text); macro != Interner::NONE) {
+                return invoke(macro, name.line);
+            } else {
+                return instruction(name);
+            }
+        }
+        if (token.kind != TokenKind::NEWLINE && token.kind != TokenKind::END) {
+            return fail("expected a label or mnemonic, found '" + std::string(token.text) + "'");
+        }
+        return true;
+    }
+
+    /*
+    Parses an assembler directive:
+    - .section <name>: starts a new Section, the unit of the Linker's garbage collection
+      (relocatable output only; ignored otherwise).
+    - .byte, .word, .fill, .align, .incbin: emit data (see data(), fill(), align(), incbin()).
+    - .macro, .rept, .irp: define and expand blocks (see define_macro(), rept(), irp()).
+    */
+    constexpr bool directive(const Token& name) {
+        flush();
+
+        if (list && (name.text == ".byte" || name.text == ".word" || name.text == ".fill" || name.text == ".align" || name.text == ".incbin")) {
+            trace(true);
+        }
+        if (name.text == ".byte" || name.text == ".word") {
+            return data(name.text == ".word" ? 2 : 1);
+        }
+        if (name.text == ".fill") {
+            return fill();
+        }
+        if (name.text == ".align") {
+            return align();
+        }
+        if (name.text == ".incbin") {
+            return incbin();
+        }
+        if (name.text == ".macro" || name.text == ".rept" || name.text == ".irp") {
+            opened = {name.text.data(), name.line, diagnostics.size(), recorded.size(), parameters.size()};
+        }
+        if (name.text == ".macro") {
+            return define_macro(name.line);
+        }
+        if (name.text == ".rept") {
+            return rept(name.line);
+        }
+        if (name.text == ".irp") {
+            return irp(name.line);
+        }
+        if (name.text == ".endm" || name.text == ".endr") {
+            error(name.line, "'" + std::string(name.text) + "' without " + (name.text == ".endm" ? "'.macro'" : "'.rept' or '.irp'"));
+            return false;
+        }
+        if (name.text == ".section") {
+            if (token.kind != TokenKind::IDENTIFIER) {
+                return fail("expected a section name");
+            }
+            if (object) {
+                Section& current = object->sections.back();
+                current.size = static_cast<uint32_t>(code.size()) - current.offset;
+
+                if (current.size || (piece && object->sections.size() == 1)) {
+                    object->sections.push_back({std::string(token.text), static_cast<uint32_t>(code.size()), 0});
+                } else {
+                    current.name = token.text;
+                }
+            }
+            advance();
+            return end_of_directive();
+        }
+        error(name.line, "unknown directive '" + std::string(name.text) + "'");
+        return false;
+    }
+
+    constexpr bool end_of_directive() {
+        return token.kind == TokenKind::NEWLINE || token.kind == TokenKind::END || fail("unexpected '" + std::string(token.text) + "' after directive");
+    }
+
+    /*
+    Parses the comma-separated values of .byte (`size` 1) or .word (`size` 2) and emits them
+    little-endian; .word values may name labels like any imm16 operand.
+    */
+    constexpr bool data(const uint8_t size) {
+        for (;;) {
+            const uint32_t line = token.line;
+            Operand value;
+
+            if (!operand(value)) {
+                return false;
+            }
+            if (value.kind == Operand::Kind::REGISTER) {
+                return fail("expected a value, found a register");
+            }
+            if (size == 1 && value.kind != Operand::Kind::IMMEDIATE) {
+                return fail("byte values must be constants");
+            }
+            if (size == 1 && (value.value < INT8_MIN || value.value > UINT8_MAX)) {
+                return fail("value " + to_decimal(value.value) + " does not fit in 8 bits");
+            }
+            uint16_t word = static_cast<uint16_t>(value.value);
+
+            if (size == 2 && !immediate_word(value, line, here(), word)) {
+                return false;
+            }
+            code.push_back(static_cast<uint8_t>(word));
+
+            if (size == 2) {
+                code.push_back(static_cast<uint8_t>(word >> 8));
+            }
+            if (token.kind != TokenKind::PUNCTUATOR || token.text[0] != ',') {
+                return end_of_directive();
+            }
+            advance();
+        }
+    }
+
+    /*
+    Parses a constant expression (no labels) into `value`, which has to lie in [`min`, `max`].
+    */
+    constexpr bool constant(int64_t& value, const int64_t min, const int64_t max, const std::string_view what) {
+        Operand parsed;
+
+        if (!operand(parsed)) {
+            return false;
+        }
+        if (parsed.kind != Operand::Kind::IMMEDIATE || parsed.value < min || parsed.value > max) {
+            return fail(std::string(what) + " must be a constant between " + to_decimal(min) + " and " + to_decimal(max));
+        }
+        value = parsed.value;
+        return true;
+    }
+
+    // Parses the `, <constant>` of an optional directive argument, leaving `value` as is without one.
+    constexpr bool argument(int64_t& value, const int64_t min, const int64_t max, const std::string_view what) {
+        if (token.kind != TokenKind::PUNCTUATOR || token.text[0] != ',') {
+            return true;
+        }
+        advance();
+        return constant(value, min, max, what);
+    }
+
+    /*
+    Parses `.fill count[, size[, value]]`: `count` copies of the `size`-byte (1 or 2) `value`, 0
+    by default.
+    */
+    constexpr bool fill() {
+        int64_t count = 0;
+        int64_t size = 1;
+        int64_t value = 0;
+
+        if (!constant(count, 0, ADDRESS_SPACE, "fill count") || !argument(size, 1, 2, "fill size") ||
+            !argument(value, size == 1 ? INT8_MIN : INT16_MIN, size == 1 ? UINT8_MAX : UINT16_MAX, "fill value") || !end_of_directive()) {
+            return false;
+        }
+        for (int64_t i = 0; i < count; i++) {
+            code.push_back(static_cast<uint8_t>(value));
+
+            if (size == 2) {
+                code.push_back(static_cast<uint8_t>(value >> 8));
+            }
+        }
+        return true;
+    }
+
+    /*
+    Parses `.align alignment[, fill]`: `fill` bytes (0 by default) up to the next multiple of the
+    power-of-two `alignment`, counted from the start of the code, or of the section in relocatable
+    output (the Linker aligns the section to its largest alignment). The padding depends on the
+    branch encodings before it, so it is reserved at its largest and sized by relax(). Padding is
+    data: execution must not fall through it.
+    */
+    constexpr bool align() {
+        const uint32_t line = token.line;
+        int64_t alignment = 1;
+        int64_t value = 0;
+
+        if (!constant(alignment, 1, ADDRESS_SPACE / 2, "alignment") || !argument(value, INT8_MIN, UINT8_MAX, "fill value") || !end_of_directive()) {
+            return false;
+        }
+        if (!std::has_single_bit(static_cast<uint64_t>(alignment))) {
+            error(line, "alignment " + to_decimal(alignment) + " is not a power of two");
+            return false;
+        }
+        if (alignment == 1) {
+            return true;
+        }
+        if (object) {
+            object->sections.back().alignment = std::max(object->sections.back().alignment, static_cast<uint32_t>(alignment));
+        }
+        aligns.push_back({here(), static_cast<uint32_t>(alignment), object ? static_cast<uint32_t>(object->sections.size() - 1) : 0,
+                          static_cast<uint8_t>(value)});
+        code.insert(code.end(), static_cast<size_t>(alignment - 1), static_cast<uint8_t>(value));
+        return true;
+    }
+
+    /*
+    Parses `.incbin path` (the rest of the line, quotes optional) and appends the file through
+    `load_file`; sources using it cannot be assembled in constant evaluation.
+    */
+    constexpr bool incbin() {
+        const uint32_t line = token.line;
+        std::string text;
+
+        for (Token previous = token; token.kind != TokenKind::NEWLINE && token.kind != TokenKind::END; previous = token, advance()) {
+            if (!text.empty() && frames.empty()) {
+                text.append(previous.text.data() + previous.text.size(), token.text.data()); // The blanks as written
+            } else if (!text.empty() && !joined(previous)) {
+                text += ' ';
+            }
+            text += token.text;
+        }
+        std::string_view path = text;
+
+        if (path.size() >= 2 && path.front() == '"' && path.back() == '"') {
+            path = path.substr(1, path.size() - 2);
+        }
+        if (path.empty()) {
+            error(line, "expected a file name");
+            return false;
+        }
+        if (!load_file) {
+            error(line, "cannot include '" + std::string(path) + "': no file access");
+            return false;
+        }
+        const std::string message = load_file(path, code);
+        included++;
+
+        if (!message.empty()) {
+            error(line, "cannot include '" + std::string(path) + "': " + message);
+            return false;
+        }
+        return true;
+    }
+
+    /*
+    Parses `.macro name [param[, param...]]` and records its body up to `.endm`. `name arg, ...`
+    as a statement then assembles the body with every `\param` replaced by the tokens of its
+    argument (see substitute()); arguments are split at commas outside parentheses and may be
+    empty. Bodies are tokenized once, here, and replayed as tokens in place of the source.
+    */
+    constexpr bool define_macro(const uint32_t line) {
+        if (const Keyword* keyword = token.kind == TokenKind::IDENTIFIER ? KEYWORDS.find(token.text) : nullptr) {
+            fail(std::string(keyword->kind == Keyword::Kind::REGISTER ? "register" : "mnemonic") + " '" + std::string(token.text) + "' used as a macro name");
+            return skip_block(line, ".endm");
+        }
+        if (token.kind != TokenKind::IDENTIFIER || token.text[0] == '.') {
+            fail("expected a macro name");
+            return skip_block(line, ".endm");
+        }
+        const std::string_view name = token.text;
+        const uint32_t first = static_cast<uint32_t>(parameters.size());
+        advance();
+
+        while (token.kind == TokenKind::IDENTIFIER) {
+            parameters.push_back(kept(token).text);
+            advance();
+
+            if (token.kind == TokenKind::PUNCTUATOR && token.text[0] == ',') {
+                advance();
+            }
+        }
+        if (!end_of_directive()) {
+            return skip_block(line, ".endm");
+        }
+        Range body;
+
+        if (!record(line, ".endm", body)) {
+            return false;
+        }
+        if (macro_names.intern(name) < macros.size()) {
+            error(line, "duplicate macro '" + std::string(name) + "'");
+            return false;
+        }
+        macros.push_back({body, first, static_cast<uint32_t>(parameters.size()) - first});
+        return true;
+    }
+
+    /*
+    Parses `.rept count`, records its body up to `.endr` and replays it `count` times.
+    */
+    constexpr bool rept(const uint32_t line) {
+        int64_t count = 0;
+
+        if (!constant(count, 0, ADDRESS_SPACE, "repeat count") || !end_of_directive()) {
+            return skip_block(line, ".endr");
+        }
+        Range body;
+        return record(line, ".endr", body) && enter(body, line, static_cast<uint32_t>(count));
+    }
+
+    /*
+    Parses `.irp param, value, ...`, records its body up to `.endr` and replays it once per value.
+    */
+    constexpr bool irp(const uint32_t line) {
+        if (token.kind != TokenKind::IDENTIFIER) {
+            fail("expected a parameter name");
+            return skip_block(line, ".endr");
+        }
+        const std::string_view name = token.text;
+        advance();
+
+        if (token.kind == TokenKind::PUNCTUATOR && token.text[0] == ',') {
+            advance();
+        } else if (!end_of_directive()) {
+            return skip_block(line, ".endr");
+        }
+        collect();
+        Range body;
+        return record(line, ".endr", body) && enter(expand(body, &name, 1, static_cast<uint32_t>(bounds.size()) - 1), line, 1);
+    }
+
+    /*
+    Expands macro `index` with the arguments on the rest of the line.
+    */
+    constexpr bool invoke(const uint32_t index, const uint32_t line) {
+        const Macro macro = macros[index];
+        collect();
+        const uint32_t count = static_cast<uint32_t>(bounds.size()) - 1;
+
+        if (count != macro.count && (macro.count || !arguments.empty())) {
+            error(line, "macro '" + std::string(macro_names.name(index)) + "' takes " + to_decimal(macro.count) + " arguments");
+            return false;
+        }
+        return enter(expand(macro.body, parameters.data() + macro.parameters, macro.count, 1), line, 1);
+    }
+
+    /*
+    Records the body of the block whose directive line ends at the current token, up to the `end`
+    directive closing it, and moves past the closing line. A body read from the source is copied
+    into `recorded`; one inside a replayed body is already there and only delimited.
+    */
+    constexpr bool record(const uint32_t line, const std::string_view end, Range& body) {
+        uint32_t depth = 0;
+
+        if (frames.empty()) {
+            body.begin = static_cast<uint32_t>(recorded.size());
+
+            for (Token previous = token;; previous = token) {
+                advance();
+
+                if (token.kind == TokenKind::END) {
+                    incomplete = streaming; // The body may continue in the next piece
+
+                    if (!incomplete) {
+                        error(line, "missing '" + std::string(end) + "'");
+                    }
+                    return false;
+                }
+                if (LEADING(previous) && CLOSES(token, depth)) {
+                    break;
+                }
+                recorded.push_back({kept(token), joined(previous)});
+            }
+            body.end = static_cast<uint32_t>(recorded.size());
+        } else {
+            Frame& frame = frames.back();
+            body.begin = frame.next;
+            uint32_t i = frame.next;
+
+            while (i < frame.body.end && !((i == body.begin || LEADING(recorded[i - 1].token)) && CLOSES(recorded[i].token, depth))) {
+                i++;
+            }
+            frame.next = std::min(i + 1, frame.body.end);
+
+            if (i == frame.body.end) {
+                error(line, "missing '" + std::string(end) + "'");
+                return false;
+            }
+            body.end = i;
+            token = recorded[i].token;
+            token.line = frame.line;
+        }
+        if (token.text != end) {
+            return fail("expected '" + std::string(end) + "', found '" + std::string(token.text) + "'");
+        }
+        advance();
+        return end_of_directive();
+    }
+
+    // Skips the rest of a block directive's line and its body, after an error on that line.
+    constexpr bool skip_block(const uint32_t line, const std::string_view end) {
+        while (token.kind != TokenKind::NEWLINE && token.kind != TokenKind::END) {
+            advance();
+        }
+        Range body;
+        record(line, end, body);
+        return false;
+    }
+
+    // Whether a token after `previous` starts a statement, after any labels.
+    static constexpr bool LEADING(const Token& previous) noexcept {
+        return previous.kind == TokenKind::NEWLINE || (previous.kind == TokenKind::PUNCTUATOR && previous.text[0] == ':');
+    }
+
+    // Tracks the block nesting at statement-leading `name`: whether it closes the recorded block.
+    static constexpr bool CLOSES(const Token& name, uint32_t& depth) noexcept {
+        if (name.kind != TokenKind::IDENTIFIER) {
+            return false;
+        }
+        if (name.text == ".macro" || name.text == ".rept" || name.text == ".irp") {
+            depth++;
+        } else if (name.text == ".endm" || name.text == ".endr") {
+            if (!depth) {
+                return true;
+            }
+            depth--;
+        }
+        return false;
+    }
+
+    /*
+    Splits the rest of the line into comma-separated arguments (see `bounds`), always at least one.
+    */
+    constexpr void collect() {
+        arguments.clear();
+        bounds.assign(1, 0);
+        int32_t depth = 0; // Parentheses
+
+        for (Token previous = token; token.kind != TokenKind::NEWLINE && token.kind != TokenKind::END; previous = token, advance()) {
+            if (token.kind == TokenKind::PUNCTUATOR && token.text[0] == ',' && !depth) {
+                bounds.push_back(static_cast<uint32_t>(arguments.size()));
+                continue;
+            }
+            if (token.kind == TokenKind::PUNCTUATOR) {
+                depth += (token.text[0] == '(') - (token.text[0] == ')');
+            }
+            arguments.push_back({kept(token), joined(previous)});
+        }
+        bounds.push_back(static_cast<uint32_t>(arguments.size()));
+    }
+
+    /*
+    Returns the expansion of `body` for the collected arguments, taken as `groups` groups of
+    `count` arguments for the parameters `names` (a macro has one group, .irp one per value), each
+    group substituting one copy of the body. Memoized by body and argument text: repeating an
+    invocation replays the tokens substituted the first time.
+    */
+    constexpr Range expand(const Range body, const std::string_view* const names, const uint32_t count, const uint32_t groups) {
+        key.clear();
+
+        for (const uint32_t bound : {body.begin, body.end}) {
+            for (uint8_t shift = 0; shift < 32; shift += 8) {
+                key += static_cast<char>(bound >> shift);
+            }
+        }
+        for (uint32_t k = 0; k + 1 < bounds.size(); k++) {
+            key += '\n';
+
+            for (uint32_t i = bounds[k]; i < bounds[k + 1]; i++) {
+                if (i > bounds[k] && !arguments[i].joined) {
+                    key += ' ';
+                }
+                key += arguments[i].token.text;
+            }
+        }
+        const uint32_t id = expansion_keys.intern(key);
+
+        if (id < expansions.size()) {
+            return expansions[id];
+        }
+        const uint32_t begin = static_cast<uint32_t>(recorded.size());
+
+        for (uint32_t group = 0; group < groups; group++) {
+            substitute(body, names, count, group * count);
+        }
+        expansions.push_back({begin, static_cast<uint32_t>(recorded.size())});
+        return expansions.back();
+    }
+
+    /*
+    Appends a copy of `body` to `recorded` with every `\name` of names[k] replaced by argument
+    first + k and every `\()` removed, pasting the words that end up joined: `L\n:` with n = 3
+    defines `L3`, and `\n\()_end` pastes `_end` onto the argument.
+    */
+    constexpr void substitute(const Range body, const std::string_view* const names, const uint32_t count, const uint32_t first) {
+        const uint32_t start = static_cast<uint32_t>(recorded.size());
+        bool glue = true; // No blank since the last emitted token
+
+        for (uint32_t i = body.begin; i < body.end; i++) {
+            RecordedToken piece = recorded[i];
+            piece.joined = piece.joined && glue;
+
+            if (piece.token.kind == TokenKind::PUNCTUATOR && piece.token.text[0] == '\\' && i + 1 < body.end && recorded[i + 1].joined) {
+                const Token next = recorded[i + 1].token;
+
+                if (next.kind == TokenKind::PUNCTUATOR && next.text[0] == '(' && i + 2 < body.end && recorded[i + 2].joined && recorded[i + 2].token.text == ")") {
+                    glue = piece.joined;
+                    i += 2;
+                    continue;
+                }
+                const uint32_t k = static_cast<uint32_t>(std::find(names, names + count, next.text) - names);
+
+                if (next.kind == TokenKind::IDENTIFIER && k < count) {
+                    for (uint32_t j = bounds[first + k]; j < bounds[first + k + 1]; j++) {
+                        emit({arguments[j].token, j == bounds[first + k] ? piece.joined : arguments[j].joined}, start);
+                    }
+                    glue = bounds[first + k] == bounds[first + k + 1] ? piece.joined : true;
+                    i++;
+                    continue;
+                }
+            }
+            emit(piece, start);
+            glue = true;
+        }
+    }
+
+    // Appends `piece` to the expansion starting at `start` in `recorded`, pasting a joined word onto a word.
+    constexpr void emit(const RecordedToken& piece, const uint32_t start) {
+        constexpr auto WORD = [](const Token& token) { return token.kind == TokenKind::IDENTIFIER || token.kind == TokenKind::NUMBER; };
+
+        if (!piece.joined || recorded.size() == start || !WORD(recorded.back().token) || !WORD(piece.token)) {
+            recorded.push_back(piece);
+            return;
+        }
+        Token& last = recorded.back().token;
+        char* const text = arena.allocate<char>(last.text.size() + piece.token.text.size());
+        std::copy(last.text.begin(), last.text.end(), text);
+        std::copy(piece.token.text.begin(), piece.token.text.end(), text + last.text.size());
+        last.text = {text, last.text.size() + piece.token.text.size()};
+    }
+
+    /*
+    Replays `body` `repeats` times in place of the source, from the next token on, up to MAX_DEPTH
+    expansions deep. Diagnostics inside it carry the line of the outermost invocation.
+    */
+    constexpr bool enter(const Range body, const uint32_t line, const uint32_t repeats) {
+        if (frames.size() == MAX_DEPTH) {
+            error(line, "expansions nested more than " + to_decimal(MAX_DEPTH) + " deep");
+            return false;
+        }
+        if (body.begin < body.end && repeats) {
+            frames.push_back({body.begin, body, line, repeats});
+        }
+        token.kind = TokenKind::NEWLINE; // Ends the line even at the end of the source, so the run loop advances into the body
+        return true;
+    }
+
+    /*
+    Defines a label at the current address and backpatches every fixup waiting for it, so the
+    source is never re-read for forward references. Code may grow past the ARCHITECTURE-bit address
+    space, but labels placed there cannot be referenced.
+    */
+    constexpr bool define(const Token& name) {
+        if (const Keyword* keyword = KEYWORDS.find(name.text)) {
+            error(name.line, std::string(keyword->kind == Keyword::Kind::REGISTER ? "register" : "mnemonic") + " '" +
+                                 std::string(name.text) + "' used as a label");
+            return false;
+        }
+        const uint32_t id = label_id(name.text);
+        Symbol& label = symbols[id];
+        flush();
+
+        if (label.defined) {
+            error(name.line, "duplicate label '" + std::string(name.text) + "'");
+            return false;
+        }
+        label.defined = true;
+        label.line = name.line;
+        label.section = object ? static_cast<uint32_t>(object->sections.size() - 1) : 0;
+        label.address = here();
+        undefined--;
+        placed.push_back(id);
+
+        if (piece) {
+            events.push_back({Event::Kind::DEFINE, id});
+        }
+
+        if (list) {
+            trace(false, true);
+        }
+        if (label.address >= ADDRESS_SPACE && label.fixups) {
+            error(name.line, "label '" + std::string(name.text) + "' lies beyond the " + to_decimal(ARCHITECTURE) + "-bit address space");
+            return false;
+        }
+        for (const Fixup* fixup = label.fixups; fixup; fixup = fixup->next) {
+            patch_word(fixup->offset, static_cast<uint16_t>(label.address));
+        }
+        label.fixups = nullptr;
+        return true;
+    }
+
+    /*
+    Parses the operands of `mnemonic` and appends its encoding to `code`.
+    */
+    constexpr bool instruction(const Token& mnemonic) {
+        const Keyword* keyword = KEYWORDS.find(mnemonic.text);
+
+        if (!keyword || keyword->kind != Keyword::Kind::MNEMONIC) {
+            error(mnemonic.line, "unknown mnemonic '" + std::string(mnemonic.text) + "'");
+            return false;
+        }
+        Opcode opcode = static_cast<Opcode>(keyword->value);
+        Operand operands[4];
+        uint8_t count = 0;
+
+        if (token.kind != TokenKind::NEWLINE && token.kind != TokenKind::END) {
+            do {
+                if (count == 4) {
+                    return fail("too many operands for " + std::string(OPCODES[static_cast<uint8_t>(opcode)].mnemonic));
+                }
+                if (count && !expect(',')) {
+                    return false;
+                }
+                if (!operand(operands[count++])) {
+                    return false;
+                }
+            } while (token.kind == TokenKind::PUNCTUATOR && token.text[0] == ',');
+        }
+        if (token.kind != TokenKind::NEWLINE && token.kind != TokenKind::END) {
+            return fail("unexpected '" + std::string(token.text) + "' after operands");
+        }
+        if (opcode == Opcode::MOV_RR && count == 2 && operands[1].kind != Operand::Kind::REGISTER) {
+            opcode = Opcode::MOV_RI;
+        }
+        const FormatInfo& format = format_info(opcode);
+        const std::string_view name = opcode_info(opcode).mnemonic;
+
+        if (count != format.operand_count) {
+            error(mnemonic.line, std::string(name) + " takes " + to_decimal(format.operand_count) + " operands");
+            return false;
+        }
+        for (uint8_t i = 0; i < count; i++) {
+            const bool immediate = format.operands[i].kind != OperandKind::REGISTER;
+
+            if ((operands[i].kind == Operand::Kind::REGISTER) == immediate) {
+                error(mnemonic.line, "operand " + to_decimal(i + 1) + " of " + std::string(name) + (immediate ? " must be an immediate" : " must be a register"));
+                return false;
+            }
+        }
+        if (opcode_info(opcode).short_form != Opcode::COUNT && operands[0].kind == Operand::Kind::SYMBOL) {
+            branch(opcode, operands[0].name, mnemonic.line);
+            return true;
+        }
+        // Label references record their offset and jumps end the block: neither may enter the Peephole window
+        const bool barrier = (opcode_info(opcode).unit == Unit::CONTROL && count) || std::any_of(operands, operands + count, [](const Operand& operand) {
+                                 return operand.kind == Operand::Kind::SYMBOL || operand.kind == Operand::Kind::EXPRESSION;
+                             });
+
+        if (barrier) {
+            flush();
+        }
+        const uint32_t start = here();
+        Instruction encoded = {opcode};
+
+        for (uint8_t i = 0; i < count; i++) {
+            const OperandField& field = format.operands[i];
+
+            if (field.kind == OperandKind::IMMEDIATE) {
+                if (!immediate_word(operands[i], mnemonic.line, start + field.byte, encoded.operands[i])) {
+                    return false;
+                }
+            } else if (field.kind == OperandKind::COUNT && (operands[i].kind != Operand::Kind::IMMEDIATE || operands[i].value < 0 || operands[i].value > UINT8_MAX)) {
+                error(mnemonic.line, "count must be a constant between 0 and 255");
+                return false;
+            } else {
+                encoded.operands[i] = static_cast<uint16_t>(operands[i].value);
+            }
+        }
+        if (optimize && !barrier) {
+            peephole.push(encoded, code);
+            return true;
+        }
+        uint8_t bytes[4];
+        encode(encoded, bytes);
+        code.insert(code.end(), bytes, bytes + format.size);
+        return true;
+    }
+
+    /*
+    Emits a relaxable branch (long form `opcode`) to label `name` as a short placeholder.
+    */
+    constexpr void branch(const Opcode opcode, const std::string_view name, const uint32_t line) {
+        const uint32_t id = label_id(name);
+        symbols[id].line = symbols[id].line ? symbols[id].line : line;
+        flush();
+        branches.push_back({here(), id, object ? static_cast<uint32_t>(object->sections.size() - 1) : 0, line, opcode});
+        code.push_back(static_cast<uint8_t>(opcode_info(opcode).short_form));
+        code.push_back(0);
+    }
+
+    /*
+    Parses a register (r0-r15, `zero`, `temp`) or a constant expression: decimal, 0x hex and 0b
+    binary numbers and labels combined with unary - ~ +, binary * / % + - << >> & ^ | (C
+    precedence) and parentheses, evaluated in 64-bit signed arithmetic. The result must fit in
+    ARCHITECTURE bits, signed or unsigned, like any literal (see LSU::MOV).
+    Folded to an IMMEDIATE when it names no label, a SYMBOL when it is a bare label, and an
+    EXPRESSION, evaluated by resolve(), otherwise.
+    */
+    constexpr bool operand(Operand& result) {
+        const uint32_t line = token.line;
+        terms.clear();
+
+        if (token.kind == TokenKind::IDENTIFIER) {
+            const Keyword* keyword = KEYWORDS.find(token.text);
+
+            if (keyword && keyword->kind == Keyword::Kind::MNEMONIC) {
+                return fail("mnemonic '" + std::string(token.text) + "' used as an operand");
+            }
+            if (keyword) {
+                result.kind = Operand::Kind::REGISTER;
+                result.value = keyword->value;
+                advance();
+                return true;
+            }
+            terms.push_back({Term::Kind::LABEL, 0, token.text}); // Spares primary() a second keyword lookup
+            advance();
+        } else if (!primary()) {
+            return false;
+        }
+        if (!operators(1)) {
+            return false;
+        }
+        if (terms.size() == 1) {
+            result.kind = terms[0].kind == Term::Kind::LABEL ? Operand::Kind::SYMBOL : Operand::Kind::IMMEDIATE;
+            result.value = terms[0].value;
+            result.name = terms[0].name;
+        } else if (std::none_of(terms.begin(), terms.end(), [](const Term& term) { return term.kind == Term::Kind::LABEL; })) {
+            Value value;
+
+            if (!evaluate(terms.data(), static_cast<uint32_t>(terms.size()), line, value)) {
+                return false;
+            }
+            result.kind = Operand::Kind::IMMEDIATE;
+            result.value = value.constant;
+        } else {
+            Term* const copy = scratch.allocate<Term>(terms.size());
+            std::copy(terms.begin(), terms.end(), copy);
+            result.kind = Operand::Kind::EXPRESSION;
+            result.value = static_cast<int64_t>(expressions.size());
+            expressions.push_back({copy, static_cast<uint32_t>(terms.size()), line});
+        }
+        return true;
+    }
+
+    /*
+    Parses the expression starting at the current token into postfix `terms`, down to binary
+    operators of `precedence` (see PRECEDENCE).
+    */
+    constexpr bool expression(const uint8_t precedence = 1) { return primary() && operators(precedence); }
+
+    /*
+    Parses the binary operators of `precedence` or tighter, and their right operands, that follow
+    an operand already in `terms`.
+    */
+    constexpr bool operators(const uint8_t precedence) {
+        for (;;) {
+            const Term::Kind kind = binary_operator();
+            const uint8_t level = PRECEDENCE(kind);
+
+            if (!level || level < precedence) {
+                return true;
+            }
+            if (kind == Term::Kind::SHIFT_LEFT || kind == Term::Kind::SHIFT_RIGHT) {
+                const char* first = token.text.data();
+                advance();
+
+                if (token.kind != TokenKind::PUNCTUATOR || token.text[0] != *first || token.text.data() != first + 1) {
+                    return fail(std::string("expected '") + *first + *first + "'");
+                }
+            }
+            advance();
+
+            if (!expression(level + 1)) {
+                return false;
+            }
+            terms.push_back({kind});
+        }
+    }
+
+    /*
+    Parses a number, a label, a parenthesized expression or a unary operator and its operand.
+    */
+    constexpr bool primary() {
+        if (token.kind == TokenKind::PUNCTUATOR) {
+            const char punctuator = token.text[0];
+
+            if (punctuator == '(') {
+                advance();
+                return expression() && expect(')');
+            }
+            if (punctuator == '-' || punctuator == '~' || punctuator == '+') {
+                advance();
+
+                if (!primary()) {
+                    return false;
+                }
+                if (punctuator != '+') {
+                    terms.push_back({punctuator == '-' ? Term::Kind::NEGATE : Term::Kind::NOT});
+                }
+                return true;
+            }
+        }
+        if (token.kind == TokenKind::NUMBER) {
+            int64_t number = 0;
+
+            if (const std::string_view problem = parse_number(token.text, number); !problem.empty()) {
+                return fail(std::string(problem) + " '" + std::string(token.text) + "'");
+            }
+            terms.push_back({Term::Kind::NUMBER, number});
+        } else if (token.kind == TokenKind::IDENTIFIER) {
+            if (const Keyword* keyword = KEYWORDS.find(token.text)) {
+                return fail(std::string(keyword->kind == Keyword::Kind::REGISTER ? "register" : "mnemonic") + " '" + std::string(token.text) +
+                            "' used in an expression");
+            }
+            terms.push_back({Term::Kind::LABEL, 0, token.text});
+        } else {
+            return fail("expected an operand, found '" + std::string(token.kind == TokenKind::NEWLINE ? "end of line" : token.text) + "'");
+        }
+        advance();
+        return true;
+    }
+
+    // Binary operator the current token starts, or NUMBER if none.
+    constexpr Term::Kind binary_operator() const noexcept {
+        if (token.kind != TokenKind::PUNCTUATOR) {
+            return Term::Kind::NUMBER;
+        }
+        switch (token.text[0]) {
+            case '*':
+                return Term::Kind::MULTIPLY;
+            case '/':
+                return Term::Kind::DIVIDE;
+            case '%':
+                return Term::Kind::REMAINDER;
+            case '+':
+                return Term::Kind::ADD;
+            case '-':
+                return Term::Kind::SUBTRACT;
+            case '<':
+                return Term::Kind::SHIFT_LEFT;
+            case '>':
+                return Term::Kind::SHIFT_RIGHT;
+            case '&':
+                return Term::Kind::AND;
+            case '^':
+                return Term::Kind::XOR;
+            case '|':
+                return Term::Kind::OR;
+            default:
+                return Term::Kind::NUMBER;
+        }
+    }
+
+    // Binding strength of binary operator `kind`, higher binds tighter; 0 if it is not one.
+    static constexpr uint8_t PRECEDENCE(const Term::Kind kind) noexcept {
+        switch (kind) {
+            case Term::Kind::MULTIPLY:
+            case Term::Kind::DIVIDE:
+            case Term::Kind::REMAINDER:
+                return 6;
+            case Term::Kind::ADD:
+            case Term::Kind::SUBTRACT:
+                return 5;
+            case Term::Kind::SHIFT_LEFT:
+            case Term::Kind::SHIFT_RIGHT:
+                return 4;
+            case Term::Kind::AND:
+                return 3;
+            case Term::Kind::XOR:
+                return 2;
+            case Term::Kind::OR:
+                return 1;
+            default:
+                return 0;
+        }
+    }
+
+    /*
+    Evaluates the postfix expression `terms` (`count` terms, labels as IDs), reporting errors
+    against `line`. A label stands for its address, or in relocatable output for itself (weight 1).
+
+    Returns:
+    - false after reporting an arithmetic error or a use of a label address that is not relocatable.
+    */
+    constexpr bool evaluate(const Term* const terms, const uint32_t count, const uint32_t line, Value& result) {
+        values.clear();
+
+        for (uint32_t i = 0; i < count; i++) {
+            const Term& term = terms[i];
+
+            if (term.kind == Term::Kind::NUMBER) {
+                values.push_back({term.value});
+                continue;
+            }
+            if (term.kind == Term::Kind::LABEL) {
+                const uint32_t id = static_cast<uint32_t>(term.value);
+
+                if (object) {
+                    values.push_back({0, 1, id});
+                } else if (symbols[id].address >= ADDRESS_SPACE) {
+                    error(line, "label '" + std::string(labels.name(id)) + "' lies beyond the " + to_decimal(ARCHITECTURE) + "-bit address space");
+                    return false;
+                } else {
+                    values.push_back({symbols[id].address});
+                }
+                continue;
+            }
+            if (term.kind == Term::Kind::NEGATE || term.kind == Term::Kind::NOT) {
+                Value& value = values.back();
+
+                if (term.kind == Term::Kind::NOT && value.weight) {
+                    error(line, "expression is not relocatable");
+                    return false;
+                }
+                if (term.kind == Term::Kind::NOT) {
+                    value.constant = ~value.constant;
+                } else if (__builtin_sub_overflow(0, value.constant, &value.constant) || __builtin_sub_overflow(0, value.weight, &value.weight)) {
+                    error(line, "expression overflows");
+                    return false;
+                }
+                continue;
+            }
+            Value rhs = values.back();
+            values.pop_back();
+            Value& lhs = values.back();
+
+            if (!apply(term.kind, lhs, rhs, line)) {
+                return false;
+            }
+        }
+        result = values.back();
+        return true;
+    }
+
+    /*
+    Applies binary operator `kind` to `lhs` and `rhs`, leaving the result in `lhs`.
+    */
+    constexpr bool apply(const Term::Kind kind, Value& lhs, Value& rhs, const uint32_t line) {
+        bool overflow = false;
+
+        if (kind == Term::Kind::ADD || kind == Term::Kind::SUBTRACT) {
+            if (lhs.weight && rhs.weight && !rebase(rhs, lhs.label)) {
+                error(line, "expression is not relocatable");
+                return false;
+            }
+            if (!lhs.weight) {
+                lhs.label = rhs.label;
+            }
+            if (kind == Term::Kind::ADD) {
+                overflow = __builtin_add_overflow(lhs.constant, rhs.constant, &lhs.constant) || __builtin_add_overflow(lhs.weight, rhs.weight, &lhs.weight);
+            } else {
+                overflow = __builtin_sub_overflow(lhs.constant, rhs.constant, &lhs.constant) || __builtin_sub_overflow(lhs.weight, rhs.weight, &lhs.weight);
+            }
+        } else if (kind == Term::Kind::MULTIPLY) {
+            if (lhs.weight && rhs.weight) {
+                error(line, "expression is not relocatable");
+                return false;
+            }
+            if (lhs.weight) {
+                std::swap(lhs, rhs);
+            }
+            const int64_t factor = lhs.constant;
+            lhs.label = rhs.label;
+            overflow = __builtin_mul_overflow(rhs.constant, factor, &lhs.constant) || __builtin_mul_overflow(rhs.weight, factor, &lhs.weight);
+        } else if (lhs.weight || rhs.weight) {
+            error(line, "expression is not relocatable");
+            return false;
+        } else if ((kind == Term::Kind::DIVIDE || kind == Term::Kind::REMAINDER) && rhs.constant == 0) {
+            error(line, "division by zero");
+            return false;
+        } else if ((kind == Term::Kind::SHIFT_LEFT || kind == Term::Kind::SHIFT_RIGHT) && (rhs.constant < 0 || rhs.constant > 63)) {
+            error(line, "shift count " + to_decimal(rhs.constant) + " is not between 0 and 63");
+            return false;
+        } else {
+            const int64_t a = lhs.constant;
+            const int64_t b = rhs.constant;
+
+            switch (kind) {
+                case Term::Kind::DIVIDE:
+                    overflow = a == INT64_MIN && b == -1;
+                    lhs.constant = overflow ? 0 : a / b;
+                    break;
+                case Term::Kind::REMAINDER:
+                    lhs.constant = b == -1 ? 0 : a % b;
+                    break;
+                case Term::Kind::SHIFT_LEFT:
+                    lhs.constant = static_cast<int64_t>(static_cast<uint64_t>(a) << b);
+                    overflow = lhs.constant >> b != a;
+                    break;
+                case Term::Kind::SHIFT_RIGHT:
+                    lhs.constant = a >> b;
+                    break;
+                case Term::Kind::AND:
+                    lhs.constant = a & b;
+                    break;
+                case Term::Kind::XOR:
+                    lhs.constant = a ^ b;
+                    break;
+                default:
+                    lhs.constant = a | b;
+                    break;
+            }
+        }
+        if (overflow) {
+            error(line, "expression overflows");
+            return false;
+        }
+        lhs.label = lhs.weight ? lhs.label : 0;
+        return true;
+    }
+
+    /*
+    Rewrites `value` relative to label `base` instead of its own label, which only works when both
+    are defined in the same section: their distance is then fixed.
+    */
+    constexpr bool rebase(Value& value, const uint32_t base) const noexcept {
+        const Symbol& from = symbols[value.label];
+        const Symbol& to = symbols[base];
+
+        if (value.label == base) {
+            return true;
+        }
+        if (!from.defined || !to.defined || from.section != to.section) {
+            return false;
+        }
+        int64_t distance = 0;
+        value.label = base;
+        return !__builtin_mul_overflow(value.weight, static_cast<int64_t>(from.address) - static_cast<int64_t>(to.address), &distance) &&
+               !__builtin_add_overflow(value.constant, distance, &value.constant);
+    }
+
+    /*
+    Resolves the imm16 operand whose field lies at `offset` to a literal or a defined label's
+    address in `word`, or leaves it 0 behind a fixup (forward reference), relocation (object output)
+    or recorded Expression.
+    */
+    constexpr bool immediate_word(const Operand& value, const uint32_t line, const uint32_t offset, uint16_t& word) {
+        if (value.kind == Operand::Kind::EXPRESSION) {
+            Expression& expression = expressions[value.value];
+            expression.offset = offset;
+
+            for (Term* term = expression.terms; term != expression.terms + expression.count; term++) {
+                if (term->kind == Term::Kind::LABEL) {
+                    term->value = label_id(term->name);
+                    symbols[term->value].line = symbols[term->value].line ? symbols[term->value].line : line;
+                }
+            }
+        } else if (value.kind == Operand::Kind::SYMBOL) {
+            const uint32_t id = label_id(value.name);
+            Symbol& label = symbols[id];
+            label.line = label.line ? label.line : line;
+
+            if (object) {
+                object->relocations.push_back({offset, id});
+                return true;
+            }
+            references.push_back({offset, id, line});
+
+            if (piece) {
+                return true; // Patched once the pieces are joined
+            }
+            if (label.defined && label.address >= ADDRESS_SPACE) {
+                error(line, "label '" + std::string(value.name) + "' lies beyond the " + to_decimal(ARCHITECTURE) + "-bit address space");
+                return false;
+            } else if (label.defined) {
+                word = static_cast<uint16_t>(label.address);
+            } else {
+                label.fixups = scratch.create<Fixup>(offset, label.fixups);
+            }
+        } else if (!FITS(value.value)) {
+            error(line, "immediate " + to_decimal(value.value) + " does not fit in " + to_decimal(ARCHITECTURE) + " bits");
+            return false;
+        } else {
+            word = static_cast<uint16_t>(value.value);
+        }
+        return true;
+    }
+
+    // Whether `value` fits in an imm16 field, as a signed or an unsigned ARCHITECTURE-bit number.
+    static constexpr bool FITS(const int64_t value) noexcept { return value >= -(int64_t(1) << (ARCHITECTURE - 1)) && value < int64_t(1) << ARCHITECTURE; }
+
+    /*
+    Evaluates every recorded Expression in the final layout and patches its value into `code`; in
+    relocatable output label differences within one section are constants, and a `label + constant`
+    result also becomes a Relocation of the label with the constant as its addend. Any other use of
+    a label address is not relocatable and is an error.
+    */
+    constexpr void resolve() {
+        std::vector<Relocation> relocations; // In code order, like `expressions`
+
+        for (const Expression& expression : expressions) {
+            const uint32_t offset = shifted(expression.offset);
+            Value value;
+
+            if (!evaluate(expression.terms, expression.count, expression.line, value)) {
+                continue;
+            }
+            if (value.weight != 0 && value.weight != 1) {
+                error(expression.line, "expression is not relocatable");
+            } else if (!FITS(value.constant)) {
+                error(expression.line, std::string(value.weight ? "addend " : "expression value ") + to_decimal(value.constant) + " does not fit in " +
+                                           to_decimal(ARCHITECTURE) + " bits");
+            } else {
+                patch_word(offset, static_cast<uint16_t>(value.constant));
+
+                if (value.weight) {
+                    relocations.push_back({offset, value.label});
+                }
+            }
+        }
+        if (!relocations.empty()) {
+            std::vector<Relocation> merged(object->relocations.size() + relocations.size());
+            std::merge(object->relocations.begin(), object->relocations.end(), relocations.begin(), relocations.end(), merged.begin(),
+                       [](const Relocation& a, const Relocation& b) { return a.offset < b.offset; });
+            object->relocations.swap(merged);
+        }
+    }
+
+    // Largest distance in the as-emitted layout between a short branch and a grown branch inside its span
+    static constexpr uint32_t REACH = 2 - INT8_MIN;
+
+    /*
+    Settles the encoding of every branch and the padding of every .align, and lays out `code`,
+    label addresses, label references, sections and relocations accordingly.
+    - Branches are emitted short; a branch whose target is out of reach grows to the long form,
+      which can push others out of reach, so this iterates to a fixed point. Only the short
+      branches within reach of a grown one are re-checked (`worklist`), and label addresses are
+      tracked through a Fenwick tree of grown branches (`growth`) instead of re-encoding.
+    - Starting from all-short and only ever growing gives the smallest layout, whatever the order.
+      A growing branch can shrink the padding of a later .align, though, so the code is cut into
+      segments after every statement that leaves no referenced label undefined (see bound()) and
+      each is settled in order, with the ones before it final. Streaming settles at the same
+      points, so both give the same layout.
+    - Branches to another section or to a label the unit does not define always take the long
+      form: only the Linker knows their distance.
+    */
+    constexpr void relax() {
+        const uint32_t count = static_cast<uint32_t>(branches.size());
+        growth.assign(count + 1, 0);
+        trimmed.assign(aligns.size() + 1, 0);
+        uint32_t grown = 0;
+
+        for (uint32_t i = 0; i < count; i++) {
+            const Symbol& label = symbols[branches[i].label];
+
+            if (!label.defined || label.section != branches[i].section) {
+                grow(i);
+                grown++;
+            }
+        }
+        Boundary first = {};
+
+        // Segment by segment: the branches of one only reach labels of it and the ones before it
+        for (size_t segment = 0; segment <= boundaries.size(); segment++) {
+            const Boundary end = segment < boundaries.size() ? boundaries[segment] : Boundary{count, static_cast<uint32_t>(aligns.size())};
+            realign(first.aligns, end.aligns);
+
+            for (uint32_t i = end.branches; i-- > first.branches;) {
+                if (!branches[i].grown) {
+                    worklist.push_back(i);
+                }
+            }
+            for (;;) {
+                while (!worklist.empty()) {
+                    const uint32_t i = worklist.back();
+                    worklist.pop_back();
+
+                    if (branches[i].grown || fits(branches[i])) {
+                        continue;
+                    }
+                    grow(i);
+                    grown++;
+                    // Only the displacements of short branches spanning branch i grew, apart from padding
+                    const uint32_t offset = branches[i].offset;
+
+                    for (uint32_t j = std::max(first.branches, first_branch(offset > REACH ? offset - REACH : 0)); j < end.branches && branches[j].offset <= offset + REACH; j++) {
+                        if (!branches[j].grown) {
+                            worklist.push_back(j);
+                        }
+                    }
+                }
+                if (first.aligns == end.aligns) {
+                    break;
+                }
+                // Grown branches move the aligns after them, whose padding may then grow too: check every branch again
+                realign(first.aligns, end.aligns);
+
+                for (uint32_t i = first.branches; i < end.branches; i++) {
+                    if (!branches[i].grown && !fits(branches[i])) {
+                        worklist.push_back(i);
+                    }
+                }
+                if (worklist.empty()) {
+                    break;
+                }
+            }
+            first = end;
+        }
+        const bool rebuild = grown || !aligns.empty();
+        std::vector<Relocation> targets; // Relocations of long branches (relocatable output)
+        relaxed.clear();
+        relaxed.reserve(rebuild ? code.size() + grown : 0);
+        uint32_t from = base;
+        size_t next_align = 0;
+
+        // Copies `code` up to as-emitted `offset` into `relaxed`, with the padding of the aligns before it
+        const auto copy = [&](const uint32_t offset) {
+            for (; next_align < aligns.size() && aligns[next_align].offset < offset; next_align++) {
+                const Align& align = aligns[next_align];
+                relaxed.insert(relaxed.end(), code.begin() + (from - base), code.begin() + (align.offset - base));
+                relaxed.insert(relaxed.end(), align.alignment - 1 - (trimmed[next_align + 1] - trimmed[next_align]), align.fill);
+                from = align.offset + align.alignment - 1;
+            }
+            relaxed.insert(relaxed.end(), code.begin() + (from - base), code.begin() + (offset - base));
+            from = offset;
+        };
+
+        for (const Branch& branch : branches) {
+            const uint32_t at = shifted(branch.offset);
+            const uint32_t target = symbols[branch.label].defined ? shifted(symbols[branch.label].address) : 0;
+            Instruction encoded = {branch.grown ? branch.opcode : opcode_info(branch.opcode).short_form};
+            uint8_t bytes[3];
+
+            if (!branch.grown) {
+                encoded.operands[0] = static_cast<uint8_t>(target - (at + 2));
+            } else if (object) {
+                targets.push_back({at + 1, branch.label});
+            } else {
+                encoded.operands[0] = static_cast<uint16_t>(target);
+            }
+            if (!object && target >= ADDRESS_SPACE) {
+                error(branch.line, "label '" + std::string(labels.name(branch.label)) + "' lies beyond the " + to_decimal(ARCHITECTURE) + "-bit address space");
+            }
+            encode(encoded, bytes);
+
+            if (rebuild) {
+                copy(branch.offset);
+                relaxed.insert(relaxed.end(), bytes, bytes + instruction_size(encoded.opcode));
+            } else {
+                std::copy(bytes, bytes + 2, code.begin() + (branch.offset - base));
+            }
+            from = branch.offset + 2;
+        }
+        if (!rebuild) {
+            return;
+        }
+        copy(here());
+        code.swap(relaxed);
+
+        for (Origin& origin : origins) {
+            origin.offset = shifted(origin.offset);
+        }
+        for (const uint32_t id : placed) {
+            symbols[id].address = shifted(symbols[id].address);
+        }
+        if (object) {
+            for (Section& section : object->sections) {
+                const uint32_t end = shifted(section.offset + section.size);
+                section.offset = shifted(section.offset);
+                section.size = end - section.offset;
+            }
+            for (Relocation& relocation : object->relocations) {
+                relocation.offset = shifted(relocation.offset);
+            }
+            std::vector<Relocation> merged(object->relocations.size() + targets.size());
+            std::merge(object->relocations.begin(), object->relocations.end(), targets.begin(), targets.end(), merged.begin(),
+                       [](const Relocation& a, const Relocation& b) { return a.offset < b.offset; });
+            object->relocations.swap(merged);
+            return;
+        }
+        const size_t boundary = diagnostics.size();
+
+        for (const Reference& reference : references) {
+            const uint32_t address = symbols[reference.label].address;
+
+            if (address >= ADDRESS_SPACE) {
+                error(reference.line, "label '" + std::string(labels.name(reference.label)) + "' lies beyond the " + to_decimal(ARCHITECTURE) + "-bit address space");
+            } else {
+                patch_word(shifted(reference.offset), static_cast<uint16_t>(address));
+            }
+        }
+        merge_diagnostics(boundary); // Branch targets, then references, each in code order
+    }
+
+    // Whether short branch `branch` reaches its target in the current layout.
+    constexpr bool fits(const Branch& branch) const noexcept {
+        const int64_t displacement = static_cast<int64_t>(shifted(symbols[branch.label].address)) - (shifted(branch.offset) + 2);
+        return displacement >= INT8_MIN && displacement <= INT8_MAX;
+    }
+
+    // Gives branch i the long form: one more byte for everything after it.
+    constexpr void grow(const uint32_t i) noexcept {
+        branches[i].grown = true;
+
+        for (uint32_t k = i + 1; k < growth.size(); k += k & (0 - k)) {
+            growth[k]++;
+        }
+    }
+
+    // Index of the first branch at or after as-emitted `offset`.
+    constexpr uint32_t first_branch(const uint32_t offset) const noexcept {
+        return static_cast<uint32_t>(std::lower_bound(branches.begin(), branches.end(), offset, [](const Branch& branch, const uint32_t value) {
+                                         return branch.offset < value;
+                                     }) - branches.begin());
+    }
+
+    // Current offset of as-emitted `offset`: shifted by one byte per grown branch before it, less the padding the aligns before it drop.
+    constexpr uint32_t shifted(const uint32_t offset) const noexcept {
+        uint32_t result = offset;
+
+        for (uint32_t k = first_branch(offset); k; k -= k & (0 - k)) {
+            result += growth[k];
+        }
+        if (!aligns.empty()) {
+            const auto align = std::lower_bound(aligns.begin(), aligns.end(), offset, [](const Align& align, const uint32_t value) { return align.offset < value; });
+            result -= trimmed[static_cast<size_t>(align - aligns.begin())];
+        }
+        return result;
+    }
+
+    /*
+    Sizes the padding of aligns [begin, end) for the current branch encodings: the bytes up to the
+    next multiple of its alignment from the start of the code, or of its section in relocatable
+    output. The aligns before `begin` are sized already.
+    */
+    constexpr void realign(const uint32_t begin, const uint32_t end) {
+        for (uint32_t k = begin; k < end; k++) {
+            const Align& align = aligns[k];
+            const uint32_t start = object ? shifted(object->sections[align.section].offset) : 0;
+            const uint32_t padding = (align.alignment - (shifted(align.offset) - start) % align.alignment) % align.alignment;
+            trimmed[k + 1] = trimmed[k] + align.alignment - 1 - padding;
+        }
+    }
+
+    constexpr void patch_word(const uint32_t offset, const uint16_t word) noexcept {
+        code[offset - base] = static_cast<uint8_t>(word);
+        code[offset - base + 1] = static_cast<uint8_t>(word >> 8);
+    }
+
+    /*
+    Formats `value` in decimal for diagnostics (std::to_string is not constexpr).
+    */
+    static constexpr std::string to_decimal(const int64_t value) {
+        char digits[20] = {};
+        char* start = digits + std::size(digits);
+        uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+
+        do {
+            *--start = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude);
+
+        if (value < 0) {
+            *--start = '-';
+        }
+        return std::string(start, digits + std::size(digits));
+    }
+
+    /*
+    Parses a decimal, 0x hexadecimal or 0b binary literal exactly into `value`.
+
+    Returns:
+    - an empty string on success, else the reason the literal was rejected.
+    */
+    static constexpr std::string_view parse_number(std::string_view text, int64_t& value) noexcept {
+        uint8_t base = 10;
+
+        if (text.size() > 2 && text[0] == '0' && ((text[1] | 0x20) == 'x' || (text[1] | 0x20) == 'b')) {
+            base = (text[1] | 0x20) == 'x' ? 16 : 2;
+            text.remove_prefix(2);
+        }
+        value = 0;
+
+        for (const char c : text) {
+            uint8_t digit = base;
+
+            if (c >= '0' && c <= '9') {
+                digit = c - '0';
+            } else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+                digit = (c | 0x20) - 'a' + 10;
+            }
+            if (digit >= base) {
+                return "invalid number";
+            }
+            if (__builtin_mul_overflow(value, int64_t(base), &value) || __builtin_add_overflow(value, int64_t(digit), &value)) {
+                return "number does not fit in 64 bits";
+            }
+        }
+        return {};
+    }
+};
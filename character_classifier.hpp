@@ -0,0 +1,141 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+/*
+Per-block character class bitmasks: bit i describes byte i of a 64-byte block.
+*/
+struct CharacterMasks {
+    uint64_t blank = 0; // ' ', '\t', '\r'
+    uint64_t newline = 0; // '\n'
+    uint64_t comment = 0; // ';'
+    uint64_t identifier = 0; // [A-Za-z0-9_.$]
+};
+
+/*
+CharacterClassifier
+
+Classifies 64 bytes of assembly source at a time into CharacterMasks, so the Lexer finds the end of
+a run of blanks, an identifier or a comment with a count-trailing-zeros instead of a byte loop
+(simdjson-style structural indexing).
+
+Implementations:
+- SCALAR: table-driven, one byte at a time. Used during constant evaluation and on non-x86 targets.
+- SSE2: four 16-byte compares per class; baseline on x86-64.
+- AVX2: two 32-byte compares per class; compiled with a target attribute, so the translation unit
+  needs no -mavx2.
+
+classify() dispatches at runtime to the widest implementation the CPU supports; the choice is
+made once, during static initialization.
+*/
+class CharacterClassifier {
+public:
+    static constexpr size_t BLOCK = 64;
+
+    /*
+    Classifies BLOCK bytes starting at `data`; all of them must be readable.
+    */
+    static constexpr CharacterMasks classify(const char* data) noexcept {
+        if (std::is_constant_evaluated()) {
+            return SCALAR(data);
+        }
+        return IMPLEMENTATION(data);
+    }
+
+    static constexpr CharacterMasks SCALAR(const char* data) noexcept {
+        CharacterMasks masks;
+
+        for (size_t i = 0; i < BLOCK; i++) {
+            const uint8_t type = CLASS_TABLE[static_cast<uint8_t>(data[i])];
+            masks.blank |= static_cast<uint64_t>(type == BLANK) << i;
+            masks.newline |= static_cast<uint64_t>(type == NEWLINE) << i;
+            masks.comment |= static_cast<uint64_t>(type == COMMENT) << i;
+            masks.identifier |= static_cast<uint64_t>(type == IDENTIFIER) << i;
+        }
+        return masks;
+    }
+
+#if defined(__x86_64__)
+    static CharacterMasks SSE2(const char* data) noexcept {
+        CharacterMasks masks;
+
+        for (size_t i = 0; i < BLOCK; i += 16) {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            const __m128i lower = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+            // Range checks via a wrapping add that moves the range to the bottom of the signed byte range
+            const __m128i letter = _mm_cmplt_epi8(_mm_add_epi8(lower, _mm_set1_epi8(static_cast<char>(128 - 'a'))), _mm_set1_epi8(static_cast<char>(-128 + 26)));
+            const __m128i digit = _mm_cmplt_epi8(_mm_add_epi8(bytes, _mm_set1_epi8(static_cast<char>(128 - '0'))), _mm_set1_epi8(static_cast<char>(-128 + 10)));
+            const __m128i symbol = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('_')),
+                                                _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('.')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('$'))));
+            const __m128i blank = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')),
+                                               _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r'))));
+            masks.blank |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(blank))) << i;
+            masks.newline |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'))))) << i;
+            masks.comment |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(';'))))) << i;
+            masks.identifier |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_or_si128(letter, _mm_or_si128(digit, symbol))))) << i;
+        }
+        return masks;
+    }
+
+    __attribute__((target("avx2"))) static CharacterMasks AVX2(const char* data) noexcept {
+        CharacterMasks masks;
+
+        for (size_t i = 0; i < BLOCK; i += 32) {
+            const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            const __m256i lower = _mm256_or_si256(bytes, _mm256_set1_epi8(0x20));
+            // Signed-compare range checks, as in SSE2 (AVX2 has no cmplt, so the operands are swapped)
+            const __m256i letter = _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(-128 + 26)), _mm256_add_epi8(lower, _mm256_set1_epi8(static_cast<char>(128 - 'a'))));
+            const __m256i digit = _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(-128 + 10)), _mm256_add_epi8(bytes, _mm256_set1_epi8(static_cast<char>(128 - '0'))));
+            const __m256i symbol = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('_')),
+                                                   _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('.')), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('$'))));
+            const __m256i blank = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')),
+                                                  _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\t')), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\r'))));
+            masks.blank |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(blank))) << i;
+            masks.newline |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n'))))) << i;
+            masks.comment |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(';'))))) << i;
+            masks.identifier |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(letter, _mm256_or_si256(digit, symbol))))) << i;
+        }
+        return masks;
+    }
+#endif
+
+private:
+    enum : uint8_t { OTHER, BLANK, NEWLINE, COMMENT, IDENTIFIER };
+
+    static constexpr auto CLASS_TABLE = [] {
+        std::array<uint8_t, 256> table{};
+
+        for (int c = 0; c < 256; c++) {
+            if (c == ' ' || c == '\t' || c == '\r') {
+                table[c] = BLANK;
+            } else if (c == '\n') {
+                table[c] = NEWLINE;
+            } else if (c == ';') {
+                table[c] = COMMENT;
+            } else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '.' || c == '$') {
+                table[c] = IDENTIFIER;
+            }
+        }
+        return table;
+    }();
+
+    using Implementation = CharacterMasks (*)(const char*) noexcept;
+
+    static Implementation SELECT() noexcept {
+#if defined(__x86_64__)
+        if (__builtin_cpu_supports("avx2")) {
+            return AVX2;
+        }
+        return SSE2;
+#else
+        return SCALAR;
+#endif
+    }
+
+    static inline const Implementation IMPLEMENTATION = SELECT();
+};
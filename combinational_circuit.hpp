@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include "bit.hpp"
 
 /*
@@ -10,6 +11,8 @@ Usage:
 - These functions operate on `Bit` objects (custom wrapper for boolean values) and model the
   behavior of hardware logic gates. They can be composed to build multi-bit adders or more complex
   arithmetic components.
+- BYTE_ADDER is an 8-bit ripple-carry adder evaluated by table lookup. The table is generated at
+  compile time from FULL_ADDER, so it is bit-identical to chaining eight full adders.
 */
 class CombinationalCircuits {
 public:
@@ -110,6 +113,28 @@ public:
     Combines FULL_ADDER_SUM and FULL_ADDER_CARRY to produce both sum and carry-out simultaneously.
     */
     static constexpr FULL_ADDER_RESULT FULL_ADDER(const Bit& x, const Bit& y, const Bit& c) noexcept;
+
+    /*
+    Result of a byte-slice adder operation.
+    Contains the 8 SUM bits (bit i of SUM is the sum output of stage i) and the final carry-out.
+    */
+    struct BYTE_ADDER_RESULT {
+        uint8_t SUM; // Sum outputs of the eight full adders
+        Bit CARRY; // Carry output of the most significant full adder
+    };
+
+    /*
+    Performs an 8-bit ripple-carry addition x + y + c in a single table lookup.
+
+    The table holds one entry per (c, x, y): the 8 sum bits and the carry-out, computed at
+    compile time by chaining eight FULL_ADDERs from the least significant bit up (as two
+    4-bit slices, which keeps the compile-time evaluation cheap).
+    */
+    static constexpr BYTE_ADDER_RESULT BYTE_ADDER(const uint8_t x, const uint8_t y, const Bit& c) noexcept;
+
+private:
+    // Byte-slice adder table indexed by (c << 16 | x << 8 | y); entries are SUM | CARRY << 8.
+    static const std::array<uint16_t, 2 << 16> BYTE_ADDER_TABLE;
 };
 
 constexpr Bit CombinationalCircuits::HALF_ADDER_SUM(const Bit& x, const Bit& y) noexcept { return x ^ y; }
@@ -127,3 +152,36 @@ constexpr Bit CombinationalCircuits::FULL_ADDER_CARRY(const Bit& x, const Bit& y
 constexpr CombinationalCircuits::FULL_ADDER_RESULT CombinationalCircuits::FULL_ADDER(const Bit& x, const Bit& y, const Bit& c) noexcept {
     return {FULL_ADDER_SUM(x, y, c), FULL_ADDER_CARRY(x, y, c)};
 }
+
+inline constexpr std::array<uint16_t, 2 << 16> CombinationalCircuits::BYTE_ADDER_TABLE = [] {
+    // Nibble slices first (four chained FULL_ADDERs per entry), indexed by (c << 8 | x << 4 | y)
+    std::array<uint8_t, 2 << 8> nibble = {};
+
+    for (uint16_t index = 0; index < nibble.size(); index++) {
+        Bit carry = index >> 8 & 1;
+        uint8_t entry = 0;
+
+        for (uint8_t i = 0; i < 4; i++) {
+            const auto [SUM, CARRY] = FULL_ADDER(index >> (4 + i) & 1, index >> i & 1, carry);
+            entry |= static_cast<bool>(SUM) << i;
+            carry = CARRY;
+        }
+        nibble[index] = entry | static_cast<bool>(carry) << 4;
+    }
+
+    // Each byte entry chains the low nibble slice into the high one
+    std::array<uint16_t, 2 << 16> table = {};
+
+    for (uint32_t index = 0; index < table.size(); index++) {
+        const uint8_t x = index >> 8, y = index;
+        const uint8_t low = nibble[(index >> 16) << 8 | (x & 0xF) << 4 | (y & 0xF)];
+        const uint8_t high = nibble[(low >> 4) << 8 | (x >> 4) << 4 | (y >> 4)];
+        table[index] = (low & 0xF) | (high & 0xF) << 4 | (high >> 4) << 8;
+    }
+    return table;
+}();
+
+constexpr CombinationalCircuits::BYTE_ADDER_RESULT CombinationalCircuits::BYTE_ADDER(const uint8_t x, const uint8_t y, const Bit& c) noexcept {
+    const uint16_t entry = BYTE_ADDER_TABLE[static_cast<bool>(c) << 16 | x << 8 | y];
+    return {static_cast<uint8_t>(entry), (entry >> 8 & 1) != 0};
+}
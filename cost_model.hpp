@@ -0,0 +1,121 @@
+#pragma once
+
+/*
+Cost Model
+
+Static cycle and logic-depth model of the ALU operations.
+
+- Cycles: number of sequential steps the modeled datapath needs (loop iterations in the ALU).
+- Depth: gate levels on the critical path of one such step (NOT/AND/OR/XOR each count as 1).
+- Follows separation of concerns (SOC): only the model lives here; the ALU reports the cost of
+  each executed operation through it, and tools (interpreter, assembler listings) consume it.
+
+Usage:
+- Data-dependent costs take the dependent quantity as a parameter (e.g. DIV iterations, MUL
+  partial-product adds). The parameter defaults to its worst case, so `CostModel::DIV()` is the
+  worst-case cost of a division.
+*/
+class CostModel {
+public:
+    /*
+    Modeled cost of one operation.
+    */
+    struct Cost {
+        uint32_t cycles = 0; // Sequential steps of the datapath
+        uint16_t depth = 0; // Gate levels on the critical path of one step
+    };
+
+    // Gate levels of a FULL_ADDER from its inputs to the carry output: XOR, AND, OR.
+    static constexpr uint16_t FULL_ADDER_DEPTH = 3;
+
+    // Gate levels of a 2:1 multiplexer (AND-OR) as used by a barrel shifter stage.
+    static constexpr uint16_t MUX_DEPTH = 2;
+
+    /*
+    Depth of a ripple-carry adder of `bits` stages.
+
+    The first stage contributes a full FULL_ADDER depth; every following stage adds the two
+    levels from carry-in to carry-out (AND, OR).
+    */
+    static constexpr uint16_t RIPPLE_DEPTH(const uint8_t bits) noexcept { return bits == 0 ? 0 : FULL_ADDER_DEPTH + 2 * (bits - 1); }
+
+    /*
+    Number of carry-save levels a Wallace tree needs to reduce `rows` partial products to two.
+    Each level compresses every group of three rows into two.
+    */
+    static constexpr uint8_t WALLACE_LEVELS(uint8_t rows) noexcept {
+        uint8_t levels = 0;
+
+        for (; rows > 2; levels++) {
+            rows -= rows / 3;
+        }
+        return levels;
+    }
+
+    // Number of stages of a logarithmic barrel shifter covering every shift count.
+    static constexpr uint8_t BARREL_STAGES() noexcept {
+        uint8_t stages = 0;
+
+        for (uint8_t width = 1; width < ARCHITECTURE; width <<= 1) {
+            stages++;
+        }
+        return stages;
+    }
+
+    // MOV (LSU): one register transfer over plain wires, no logic on the path.
+    static constexpr Cost MOV() noexcept { return {1, 0}; }
+
+    // JMP/Jcc (long): the flag test selects the next pc in one 2:1 multiplexer.
+    static constexpr Cost JUMP() noexcept { return {1, MUX_DEPTH}; }
+
+    // JMP/Jcc (short): the displacement is added to the pc in the ripple-carry adder before the select.
+    static constexpr Cost RELATIVE_JUMP() noexcept { return {1, static_cast<uint16_t>(RIPPLE_DEPTH(ARCHITECTURE) + MUX_DEPTH)}; }
+
+    // HLT: stops the core; no logic on the path.
+    static constexpr Cost HALT() noexcept { return {1, 0}; }
+
+    // ADD: one pass through the ripple-carry adder.
+    static constexpr Cost ADD() noexcept { return {1, RIPPLE_DEPTH(ARCHITECTURE)}; }
+
+    // SUB/CMP: one pass through the ripple-carry adder behind the rhs inverters.
+    static constexpr Cost SUB() noexcept { return {1, static_cast<uint16_t>(1 + RIPPLE_DEPTH(ARCHITECTURE))}; }
+
+    // INC/DEC: the ripple stops after `bits` stages once the carry dies out.
+    static constexpr Cost INC(const uint8_t bits = ARCHITECTURE) noexcept { return {1, RIPPLE_DEPTH(bits)}; }
+
+    // NEG: subtraction from zero followed by the flag compare.
+    static constexpr Cost NEG() noexcept { return {2, SUB().depth}; }
+
+    /*
+    MUL: shift-and-add, one shift per multiplier bit plus one ADD per set multiplier bit
+    (`adds` partial products).
+    */
+    static constexpr Cost MUL(const uint8_t adds = ARCHITECTURE) noexcept { return {static_cast<uint32_t>(ARCHITECTURE + adds), ADD().depth}; }
+
+    /*
+    MAC: single fused step. AND partial products, Wallace tree reduction, product resolution
+    and accumulation are chained combinationally over 2 * ARCHITECTURE bits.
+    */
+    static constexpr Cost MAC() noexcept {
+        return {1, static_cast<uint16_t>(1 + 1 + WALLACE_LEVELS(ARCHITECTURE) * FULL_ADDER_DEPTH + 2 * RIPPLE_DEPTH(2 * ARCHITECTURE))};
+    }
+
+    // MULH: MAC's multiplier without the accumulation: AND partial products, Wallace tree, product resolution.
+    static constexpr Cost MULH() noexcept {
+        return {1, static_cast<uint16_t>(1 + WALLACE_LEVELS(ARCHITECTURE) * FULL_ADDER_DEPTH + RIPPLE_DEPTH(2 * ARCHITECTURE))};
+    }
+
+    /*
+    DIV: repeated subtraction; `iterations` trial subtractions (quotient + 1), one INC per
+    successful subtraction, the zero-divisor check, the final restore ADD and flag compare.
+    */
+    static constexpr Cost DIV(const uint32_t iterations = (1u << ARCHITECTURE)) noexcept {
+        return {2 * iterations + 2, SUB().depth};
+    }
+
+    // SHL/SHR/SAR: one pass through the barrel shifter followed by the zero detect.
+    static constexpr Cost SHIFT() noexcept { return {1, static_cast<uint16_t>(BARREL_STAGES() * MUX_DEPTH)}; }
+
+    // ROL/ROR: one single-bit rotation per step, `count` steps.
+    static constexpr Cost ROTATE(const uint8_t count = ARCHITECTURE - 1) noexcept { return {count == 0 ? 1u : count, MUX_DEPTH}; }
+};
@@ -9,6 +9,24 @@ CPU Architecture Constants
 
 using uint8_t = unsigned char;
 using int8_t = signed char;
+using uint16_t = unsigned short;
+using uint32_t = unsigned int;
 constexpr uint8_t ARCHITECTURE = 16;
 
+// Native words matching the register width and the width of an accumulator register pair.
+using WORD = unsigned short;
+using DWORD = unsigned int;
+static_assert(sizeof(WORD) * 8 == ARCHITECTURE && sizeof(DWORD) * 8 == 2 * ARCHITECTURE);
+
+/*
+Simulation fidelity of an ALU operation.
+
+- GATE: evaluated bit by bit through the `Bit`/`CombinationalCircuits` gate model.
+- LOOKUP: adders evaluated a byte per lookup through CombinationalCircuits::BYTE_ADDER.
+- NATIVE: evaluated with host word arithmetic; results and flags match the gate model.
+- CHECKED: evaluated natively; a sample of the operations is also evaluated gate by gate in
+  lockstep and divergences are recorded (see ALUChecker).
+*/
+enum class Fidelity : uint8_t { GATE, LOOKUP, NATIVE, CHECKED };
+
 #include "alu.hpp"
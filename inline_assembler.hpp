@@ -0,0 +1,87 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include "assembler.hpp"
+#include "interpreter.hpp"
+
+/*
+Inline assembly
+
+The `_asm` string literal assembles its source entirely at compile time, with the same Assembler
+the command-line tool uses, into a std::array of machine code:
+
+    constexpr auto program = "MOV r0, 50\nINC r0"_asm; // std::array<uint8_t, 6>
+
+Programs embedded this way cost nothing to parse or load at run time, and the constexpr
+Interpreter can run them inside static_asserts:
+
+    static_assert([] { Interpreter cpu; cpu.run(program); return cpu[0]; }() == 51);
+
+A source that does not assemble is a compile error, pointing at inline_assembly_error; assemble it
+at run time (Assembler::assemble) to read the diagnostics.
+*/
+
+/*
+Source text of an `_asm` literal, as a structural type so it can be a template argument.
+*/
+template <size_t N>
+struct AssemblySource {
+    char text[N] = {};
+
+    consteval AssemblySource(const char (&source)[N]) noexcept { std::copy_n(source, N, text); }
+
+    constexpr std::string_view view() const noexcept { return {text, N - 1}; }
+};
+
+// Deliberately not constexpr: reaching it in constant evaluation turns a failed assembly into a compile error.
+inline void inline_assembly_error() noexcept {}
+
+/*
+Assembles SOURCE at compile time.
+
+Returns:
+- std::array<uint8_t, N> holding the N bytes of machine code.
+*/
+template <AssemblySource SOURCE>
+consteval auto operator""_asm() {
+    constexpr size_t SIZE = [] {
+        Assembler assembler;
+
+        if (!assembler.assemble(SOURCE.view())) {
+            inline_assembly_error();
+        }
+        return assembler.code.size();
+    }();
+    Assembler assembler;
+    assembler.assemble(SOURCE.view());
+    std::array<uint8_t, SIZE> code = {};
+    std::copy(assembler.code.begin(), assembler.code.end(), code.begin());
+    return code;
+}
+
+static_assert("MOV r0, 50\nINC r0"_asm == std::array<uint8_t, 6>{1, 0, 50, 0, 7, 0});
+static_assert("start: MOV r1, end\n ADD r0, r1\nend:"_asm == std::array<uint8_t, 6>{1, 1, 6, 0, 2, 0x01},
+              "forward references are backpatched in constant evaluation");
+static_assert("MOV r0, (end - start) * 2 + 1\nstart: JMP start\nend:"_asm == std::array<uint8_t, 6>{1, 0, 5, 0, static_cast<uint8_t>(Opcode::JMP_SHORT), 0xFE},
+              "expressions over labels are evaluated in constant evaluation");
+static_assert(".macro inc2 r\nINC \\r\nINC \\r\n.endm\ninc2 r0\n.rept 2\ninc2 r1\n.endr"_asm == std::array<uint8_t, 12>{7, 0, 7, 0, 7, 1, 7, 1, 7, 1, 7, 1},
+              "macros are expanded in constant evaluation");
+static_assert("MOV r1, 2147483648 - 2147483647"_asm == std::array<uint8_t, 4>{1, 1, 1, 0}, "literals are parsed exactly, not saturated");
+static_assert([] {
+    Assembler assembler;
+    return !assembler.assemble("MOV r0, 4294967296 >> 16") && !assembler.assemble("MOV r2, 99999999999 / 1000000") &&
+           !assembler.assemble("MOV r3, 9223372036854775808");
+}(), "literals and results beyond their range are errors");
+static_assert("loop: JMP loop"_asm == std::array<uint8_t, 2>{static_cast<uint8_t>(Opcode::JMP_SHORT), 0xFE}, "branches are relaxed in constant evaluation");
+static_assert([] {
+    Interpreter cpu;
+    cpu.run("MOV r0, 6\nMOV r1, 7\nMUL r0, r1\nMOV r2, 100\nDIV r2, r1\nSHL r2, 2"_asm);
+    return cpu[0] == 42 && cpu[2] == 56 && !cpu.faulted;
+}(), "programs run at compile time");
+static_assert([] {
+    Interpreter cpu;
+    cpu.run("MOV r0, 10\nloop: ADD r1, r0\nDEC r0\nJNZ loop\nHLT\nMOV r1, 0"_asm);
+    return cpu[1] == 55 && cpu.halted;
+}(), "branches run at compile time");
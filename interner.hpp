@@ -0,0 +1,115 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "arena.hpp"
+
+/*
+Interner
+
+Maps names to dense integer IDs (0, 1, 2, ... in order of first appearance), so the assembler keys
+its symbol data by plain vector index instead of by string.
+
+Table:
+- Open addressing with linear probing over a power-of-two slot array kept at most half full. A slot
+  stores the name's 32-bit hash next to its ID, so probes compare strings only on a hash match.
+- Names are copied into the Arena the first time they are seen, so IDs stay valid independently of
+  the source buffer until clear() (which also has to precede any Arena::reset()).
+*/
+class Interner {
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    constexpr explicit Interner(Arena& arena) noexcept : arena(arena) {}
+
+    /*
+    Returns the ID of `name`, assigning the next free ID if it has not been seen before.
+    */
+    constexpr uint32_t intern(const std::string_view name) {
+        if ((names.size() + 1) * 2 > slots.size()) {
+            rehash(slots.empty() ? 64 : slots.size() * 2);
+        }
+        const uint32_t hash = HASH(name);
+        const size_t mask = slots.size() - 1;
+
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            Slot& slot = slots[i];
+
+            if (slot.id == NONE) {
+                slot = {hash, static_cast<uint32_t>(names.size())};
+                names.push_back(arena.copy(name));
+                return slot.id;
+            }
+            if (slot.hash == hash && names[slot.id] == name) {
+                return slot.id;
+            }
+        }
+    }
+
+    /*
+    Returns the ID of `name`, or NONE if it has never been interned.
+    */
+    constexpr uint32_t find(const std::string_view name) const noexcept {
+        if (slots.empty()) {
+            return NONE;
+        }
+        const uint32_t hash = HASH(name);
+        const size_t mask = slots.size() - 1;
+
+        for (size_t i = hash & mask; slots[i].id != NONE; i = (i + 1) & mask) {
+            if (slots[i].hash == hash && names[slots[i].id] == name) {
+                return slots[i].id;
+            }
+        }
+        return NONE;
+    }
+
+    constexpr std::string_view name(const uint32_t id) const noexcept { return names[id]; }
+
+    constexpr uint32_t size() const noexcept { return static_cast<uint32_t>(names.size()); }
+
+    /*
+    Forgets every name, keeping the table's capacity.
+    */
+    constexpr void clear() noexcept {
+        std::fill(slots.begin(), slots.end(), Slot{});
+        names.clear();
+    }
+
+private:
+    struct Slot {
+        uint32_t hash = 0;
+        uint32_t id = NONE;
+    };
+
+    Arena& arena;
+    std::vector<Slot> slots;
+    std::vector<std::string_view> names; // Indexed by ID, views into the Arena
+
+    constexpr void rehash(const size_t size) {
+        std::vector<Slot> old(size);
+        old.swap(slots);
+
+        for (const Slot& slot : old) {
+            if (slot.id != NONE) {
+                size_t i = slot.hash & (size - 1);
+
+                while (slots[i].id != NONE) {
+                    i = (i + 1) & (size - 1);
+                }
+                slots[i] = slot;
+            }
+        }
+    }
+
+    // FNV-1a, 32-bit
+    static constexpr uint32_t HASH(const std::string_view name) noexcept {
+        uint32_t hash = 2166136261u;
+
+        for (const char c : name) {
+            hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+        }
+        return hash;
+    }
+};
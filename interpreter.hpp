@@ -0,0 +1,180 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include "isa.hpp"
+
+/*
+Interpreter
+
+Executes machine code (see isa.hpp) on a register set with the ALU and LSU.
+
+Dispatch:
+- Each step decodes one instruction with decode() and calls its handler from HANDLERS, a table
+  generated at compile time from OPCODES: an opcode's unit selects an LSU move or an ALU::execute
+  call, and its format's operand roles (OperandField::role) select the ALU operands the decoded
+  fields feed. Adding an opcode to OPCODES is enough to make it executable.
+- The conventional registers (ZERO_REGISTER, TEMP_REGISTER, QUOTIENT_REGISTER) are passed to
+  every ALU operation as its zero, temporary and quotient registers.
+- CONTROL opcodes test their Condition against the ALU flags and load the pc with the absolute
+  target or add the displacement to it; HLT stops the program.
+
+Cost:
+- `cycles` accumulates the modeled cost of every executed instruction: the ALU's data-dependent
+  cost for ALU operations (ALU::cost) and the opcode's OPCODES cost otherwise.
+
+Every step is constexpr, so a program assembled with `_asm` can be run inside a static_assert.
+*/
+template <Fidelity FIDELITY = Fidelity::GATE>
+class Interpreter {
+public:
+    Register* const registers = Register::instantiate_register_set(); // REGISTER_COUNT registers, initially 0
+    ALU<FIDELITY> alu;
+    uint32_t pc = 0; // Offset of the next instruction in the code
+    uint64_t cycles = 0; // Modeled cycles of the executed instructions
+    uint64_t executed = 0; // Instructions executed
+    bool faulted = false; // An invalid or truncated instruction was reached
+    bool halted = false; // HLT was executed
+
+    constexpr Interpreter() = default;
+    Interpreter(const Interpreter&) = delete;
+    Interpreter& operator=(const Interpreter&) = delete;
+
+    constexpr ~Interpreter() { delete[] registers; }
+
+    /*
+    Executes the instruction at `pc` in `code` (`size` bytes).
+
+    Returns:
+    - false if `pc` is at the end of the code, the program halted or the instruction is invalid
+      (sets `faulted`).
+    */
+    constexpr bool step(const uint8_t* const code, const size_t size) noexcept {
+        if (pc >= size || halted) {
+            return false;
+        }
+        Instruction instruction;
+        const uint8_t length = decode(code + pc, size - pc, instruction);
+
+        if (!length) {
+            faulted = true;
+            return false;
+        }
+        pc += length;
+        (this->*HANDLERS[static_cast<uint8_t>(instruction.opcode)])(instruction);
+        executed++;
+        return true;
+    }
+
+    /*
+    Executes `code` from `pc` until it runs off the end, halts or faults.
+
+    Returns:
+    - false if it faulted.
+    */
+    template <size_t N>
+    constexpr bool run(const std::array<uint8_t, N>& code) noexcept {
+        return run(code.data(), code.size());
+    }
+
+    constexpr bool run(const uint8_t* const code, const size_t size) noexcept {
+        while (step(code, size)) {}
+        return !faulted;
+    }
+
+    // Value of register `index`.
+    constexpr WORD operator[](const uint8_t index) const noexcept { return static_cast<WORD>(registers[index]); }
+
+private:
+    using Handler = void (Interpreter::*)(const Instruction&) noexcept;
+
+    // Executes opcode OP as described by OPCODES and FORMATS.
+    template <Opcode OP>
+    constexpr void EXECUTE(const Instruction& instruction) noexcept {
+        constexpr OpcodeInfo INFO = opcode_info(OP);
+        constexpr FormatInfo FORMAT = format_info(OP);
+
+        if constexpr (INFO.unit == Unit::LSU) {
+            static_assert(FORMAT.operand_count == 2 && FORMAT.operands[0].kind == OperandKind::REGISTER);
+
+            if constexpr (FORMAT.operands[1].kind == OperandKind::REGISTER) {
+                LSU::MOV(registers[instruction.operands[0]], registers[instruction.operands[1]]);
+            } else {
+                LSU::MOV(registers[instruction.operands[0]], instruction.operands[1]);
+            }
+            cycles += INFO.cost.cycles;
+        } else if constexpr (INFO.unit == Unit::CONTROL) {
+            if constexpr (FORMAT.operand_count == 0) {
+                halted = true;
+            } else if (TAKEN<INFO.condition>()) {
+                if constexpr (FORMAT.operands[0].kind == OperandKind::RELATIVE) {
+                    pc += static_cast<int8_t>(instruction.operands[0]);
+                } else {
+                    pc = instruction.operands[0];
+                }
+            }
+            cycles += INFO.cost.cycles;
+        } else {
+            ALUOperands operands = {.temp = &registers[TEMP_REGISTER], .zero = &registers[ZERO_REGISTER], .quotient = &registers[QUOTIENT_REGISTER]};
+
+            for (uint8_t i = 0; i < FORMAT.operand_count; i++) {
+                Register* const reg = FORMAT.operands[i].kind == OperandKind::REGISTER ? &registers[instruction.operands[i]] : nullptr;
+
+                switch (FORMAT.operands[i].role) {
+                    case OperandRole::LHS:
+                        operands.lhs = reg;
+                        break;
+                    case OperandRole::RHS:
+                        operands.rhs = reg;
+                        break;
+                    case OperandRole::COUNT:
+                        operands.count = static_cast<uint8_t>(instruction.operands[i]);
+                        break;
+                    case OperandRole::ACC_HI:
+                        operands.acc_hi = reg;
+                        break;
+                    case OperandRole::ACC_LO:
+                        operands.acc_lo = reg;
+                        break;
+                    case OperandRole::TARGET: // CONTROL opcodes only
+                        break;
+                }
+            }
+            alu.execute(INFO.operation, operands);
+            cycles += alu.cost.cycles;
+        }
+    }
+
+    // Whether the ALU flags satisfy branch condition CONDITION.
+    template <Condition CONDITION>
+    constexpr bool TAKEN() const noexcept {
+        switch (CONDITION) {
+            case Condition::ALWAYS:
+                return true;
+            case Condition::ZERO:
+                return static_cast<bool>(alu.ZF);
+            case Condition::NOT_ZERO:
+                return !alu.ZF;
+            case Condition::SIGN:
+                return static_cast<bool>(alu.SF);
+            case Condition::NOT_SIGN:
+                return !alu.SF;
+            case Condition::CARRY:
+                return static_cast<bool>(alu.CF);
+            case Condition::NOT_CARRY:
+                return !alu.CF;
+            case Condition::OVERFLOW:
+                return static_cast<bool>(alu.OF);
+            case Condition::NOT_OVERFLOW:
+                return !alu.OF;
+        }
+        return false;
+    }
+
+    // Handler table indexed by Opcode, generated at compile time from EXECUTE.
+    static constexpr std::array<Handler, static_cast<uint8_t>(Opcode::COUNT)> HANDLERS =
+        []<uint8_t... OP>(std::integer_sequence<uint8_t, OP...>) {
+            return std::array<Handler, sizeof...(OP)>{&Interpreter::EXECUTE<static_cast<Opcode>(OP)>...};
+        }(std::make_integer_sequence<uint8_t, static_cast<uint8_t>(Opcode::COUNT)>{});
+};
@@ -0,0 +1,311 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "cpu.hpp"
+
+/*
+Instruction Set Architecture (ISA)
+
+Machine encoding of the instructions the assembler emits, described once in constexpr tables:
+FORMATS lays out the operand fields of each encoding and OPCODES gives every opcode its mnemonic,
+format, executing unit and modeled cost. The assembler's encoder, the decoder (decode), the
+disassembler (disassemble) and the Interpreter's dispatch table are all generated from them.
+Follows separation of concerns (SOC): only opcodes, formats and register conventions here.
+
+Encoding:
+- Every instruction starts with one opcode byte; the format of the opcode fixes the size and the
+  layout of the operand bytes that follow. Registers are 4-bit fields; immediates are
+  little-endian ARCHITECTURE-bit words.
+
+Formats:
+- R:    [opcode][reg]                          2 bytes (INC, DEC, NEG)
+- RR:   [opcode][dst << 4 | src]               2 bytes (MOV, ADD, SUB, MUL, DIV, CMP, MULH)
+- RI:   [opcode][reg][imm lo][imm hi]          4 bytes (MOV reg, imm)
+- RC:   [opcode][reg][count]                   3 bytes (SHL, SHR, SAR, ROL, ROR)
+- RRRR: [opcode][hi << 4 | lo][lhs << 4 | rhs] 3 bytes (MAC hi, lo, lhs, rhs)
+- J8:   [opcode][rel8]                         2 bytes (short JMP/Jcc)
+- J16:  [opcode][addr lo][addr hi]             3 bytes (long JMP/Jcc)
+- NONE: [opcode]                               1 byte  (HLT)
+
+Branches:
+- JMP and the conditional jumps (JZ, JNZ, JS, JNS, JC, JNC, JO, JNO test the ALU flags left by the
+  last ALU operation) come in two encodings under one mnemonic: the long form holds the absolute
+  target address, the short form a signed displacement from the end of the jump. The assembler
+  picks the short form whenever the target is in reach (see OpcodeInfo::short_form).
+
+Register conventions:
+- r15 (alias `zero`) is the zero register and r14 (alias `temp`) the temporary the ALU
+  operations take as caller-provided registers; r13 holds the DIV quotient temporary.
+*/
+
+constexpr uint8_t REGISTER_COUNT = 16;
+constexpr uint8_t ZERO_REGISTER = 15;
+constexpr uint8_t TEMP_REGISTER = 14;
+constexpr uint8_t QUOTIENT_REGISTER = 13;
+
+// Operand layouts of the encoded instructions (see the ISA overview above).
+enum class Format : uint8_t { R, RR, RI, RC, RRRR, J8, J16, NONE };
+
+// What an operand field holds.
+enum class OperandKind : uint8_t { REGISTER, IMMEDIATE, COUNT, RELATIVE };
+
+// ALU operand an operand field feeds (ALUOperands field); for MOV, LHS is the destination and RHS the source.
+// TARGET is the destination of a branch: an absolute address (IMMEDIATE) or a signed displacement (RELATIVE).
+enum class OperandRole : uint8_t { LHS, RHS, COUNT, ACC_HI, ACC_LO, TARGET };
+
+/*
+Position of one operand in an encoded instruction: `bits` bits starting at bit `shift` of byte
+`byte`, continuing little-endian into the following bytes.
+*/
+struct OperandField {
+    OperandKind kind;
+    OperandRole role;
+    uint8_t byte;
+    uint8_t shift;
+    uint8_t bits;
+};
+
+/*
+Static description of an encoding format.
+*/
+struct FormatInfo {
+    uint8_t size; // Encoded size in bytes, opcode included
+    uint8_t operand_count;
+    std::array<OperandField, 4> operands; // In assembly operand order
+};
+
+// Layout of every Format, indexed by Format.
+constexpr std::array<FormatInfo, 8> FORMATS = {{
+    {2, 1, {{{OperandKind::REGISTER, OperandRole::LHS, 1, 0, 4}}}},
+    {2, 2, {{{OperandKind::REGISTER, OperandRole::LHS, 1, 4, 4}, {OperandKind::REGISTER, OperandRole::RHS, 1, 0, 4}}}},
+    {4, 2, {{{OperandKind::REGISTER, OperandRole::LHS, 1, 0, 4}, {OperandKind::IMMEDIATE, OperandRole::RHS, 2, 0, ARCHITECTURE}}}},
+    {3, 2, {{{OperandKind::REGISTER, OperandRole::LHS, 1, 0, 4}, {OperandKind::COUNT, OperandRole::COUNT, 2, 0, 8}}}},
+    {3, 4, {{{OperandKind::REGISTER, OperandRole::ACC_HI, 1, 4, 4}, {OperandKind::REGISTER, OperandRole::ACC_LO, 1, 0, 4},
+             {OperandKind::REGISTER, OperandRole::LHS, 2, 4, 4}, {OperandKind::REGISTER, OperandRole::RHS, 2, 0, 4}}}},
+    {2, 1, {{{OperandKind::RELATIVE, OperandRole::TARGET, 1, 0, 8}}}},
+    {3, 1, {{{OperandKind::IMMEDIATE, OperandRole::TARGET, 1, 0, ARCHITECTURE}}}},
+    {1, 0, {}},
+}};
+
+// Machine opcodes; the value is the opcode byte.
+// Long and short forms of a branch are adjacent, the long form first.
+enum class Opcode : uint8_t {
+    MOV_RR, MOV_RI, ADD, SUB, MUL, MAC, DIV, INC, DEC, NEG, SHL, SHR, SAR, ROL, ROR, CMP,
+    JMP, JMP_SHORT, JZ, JZ_SHORT, JNZ, JNZ_SHORT, JS, JS_SHORT, JNS, JNS_SHORT,
+    JC, JC_SHORT, JNC, JNC_SHORT, JO, JO_SHORT, JNO, JNO_SHORT, HLT, MULH, COUNT
+};
+
+// Functional unit executing an opcode; CONTROL changes the pc (branches, HLT).
+enum class Unit : uint8_t { LSU, ALU, CONTROL };
+
+// ALU flag test of a conditional branch.
+enum class Condition : uint8_t { ALWAYS, ZERO, NOT_ZERO, SIGN, NOT_SIGN, CARRY, NOT_CARRY, OVERFLOW, NOT_OVERFLOW };
+
+/*
+Static description of a machine opcode.
+*/
+struct OpcodeInfo {
+    std::string_view mnemonic; // Assembly mnemonic
+    Format format; // Operand layout
+    Unit unit; // Executing unit
+    ALUOpcode operation; // ALU operation, if unit is ALU
+    CostModel::Cost cost; // Worst-case modeled cost (see CostModel)
+    Condition condition = Condition::ALWAYS; // Branch condition, if unit is CONTROL
+    Opcode short_form = Opcode::COUNT; // J8 encoding of a J16 branch, COUNT if it has none
+};
+
+// Description of every machine opcode, indexed by Opcode.
+constexpr std::array<OpcodeInfo, static_cast<uint8_t>(Opcode::COUNT)> OPCODES = {{
+    {"MOV", Format::RR, Unit::LSU, ALUOpcode::COUNT, CostModel::MOV()},
+    {"MOV", Format::RI, Unit::LSU, ALUOpcode::COUNT, CostModel::MOV()},
+    {"ADD", Format::RR, Unit::ALU, ALUOpcode::ADD, CostModel::ADD()},
+    {"SUB", Format::RR, Unit::ALU, ALUOpcode::SUB, CostModel::SUB()},
+    {"MUL", Format::RR, Unit::ALU, ALUOpcode::MUL, CostModel::MUL()},
+    {"MAC", Format::RRRR, Unit::ALU, ALUOpcode::MAC, CostModel::MAC()},
+    {"DIV", Format::RR, Unit::ALU, ALUOpcode::DIV, CostModel::DIV()},
+    {"INC", Format::R, Unit::ALU, ALUOpcode::INC, CostModel::INC()},
+    {"DEC", Format::R, Unit::ALU, ALUOpcode::DEC, CostModel::INC()},
+    {"NEG", Format::R, Unit::ALU, ALUOpcode::NEG, CostModel::NEG()},
+    {"SHL", Format::RC, Unit::ALU, ALUOpcode::SHL, CostModel::SHIFT()},
+    {"SHR", Format::RC, Unit::ALU, ALUOpcode::SHR, CostModel::SHIFT()},
+    {"SAR", Format::RC, Unit::ALU, ALUOpcode::SAR, CostModel::SHIFT()},
+    {"ROL", Format::RC, Unit::ALU, ALUOpcode::ROL, CostModel::ROTATE()},
+    {"ROR", Format::RC, Unit::ALU, ALUOpcode::ROR, CostModel::ROTATE()},
+    {"CMP", Format::RR, Unit::ALU, ALUOpcode::CMP, CostModel::SUB()},
+    {"JMP", Format::J16, Unit::CONTROL, ALUOpcode::COUNT, CostModel::JUMP(), Condition::ALWAYS, Opcode::JMP_SHORT},
+    {"JMP", Format::J8, Unit::CONTROL, ALUOpcode::COUNT, CostModel::RELATIVE_JUMP(), Condition::ALWAYS},
+    {"JZ", Format::J16, Unit::CONTROL, ALUOpcode::COUNT, CostModel::JUMP(), Condition::ZERO, Opcode::JZ_SHORT},
+    {"JZ", Format::J8, Unit::CONTROL, ALUOpcode::COUNT, CostModel::RELATIVE_JUMP(), Condition::ZERO},
+    {"JNZ", Format::J16, Unit::CONTROL, ALUOpcode::COUNT, CostModel::JUMP(), Condition::NOT_ZERO, Opcode::JNZ_SHORT},
+    {"JNZ", Format::J8, Unit::CONTROL, ALUOpcode::COUNT, CostModel::RELATIVE_JUMP(), Condition::NOT_ZERO},
+    {"JS", Format::J16, Unit::CONTROL, ALUOpcode::COUNT, CostModel::JUMP(), Condition::SIGN, Opcode::JS_SHORT},
+    {"JS", Format::J8, Unit::CONTROL, ALUOpcode::COUNT, CostModel::RELATIVE_JUMP(), Condition::SIGN},
+    {"JNS", Format::J16, Unit::CONTROL, ALUOpcode::COUNT, CostModel::JUMP(), Condition::NOT_SIGN, Opcode::JNS_SHORT},
+    {"JNS", Format::J8, Unit::CONTROL, ALUOpcode::COUNT, CostModel::RELATIVE_JUMP(), Condition::NOT_SIGN},
+    {"JC", Format::J16, Unit::CONTROL, ALUOpcode::COUNT, CostModel::JUMP(), Condition::CARRY, Opcode::JC_SHORT},
+    {"JC", Format::J8, Unit::CONTROL, ALUOpcode::COUNT, CostModel::RELATIVE_JUMP(), Condition::CARRY},
+    {"JNC", Format::J16, Unit::CONTROL, ALUOpcode::COUNT, CostModel::JUMP(), Condition::NOT_CARRY, Opcode::JNC_SHORT},
+    {"JNC", Format::J8, Unit::CONTROL, ALUOpcode::COUNT, CostModel::RELATIVE_JUMP(), Condition::NOT_CARRY},
+    {"JO", Format::J16, Unit::CONTROL, ALUOpcode::COUNT, CostModel::JUMP(), Condition::OVERFLOW, Opcode::JO_SHORT},
+    {"JO", Format::J8, Unit::CONTROL, ALUOpcode::COUNT, CostModel::RELATIVE_JUMP(), Condition::OVERFLOW},
+    {"JNO", Format::J16, Unit::CONTROL, ALUOpcode::COUNT, CostModel::JUMP(), Condition::NOT_OVERFLOW, Opcode::JNO_SHORT},
+    {"JNO", Format::J8, Unit::CONTROL, ALUOpcode::COUNT, CostModel::RELATIVE_JUMP(), Condition::NOT_OVERFLOW},
+    {"HLT", Format::NONE, Unit::CONTROL, ALUOpcode::COUNT, CostModel::HALT()},
+    {"MULH", Format::RR, Unit::ALU, ALUOpcode::MULH, CostModel::MULH()},
+}};
+
+static_assert([] {
+    for (uint8_t i = 0; i < OPCODES.size(); i++) {
+        if ((OPCODES[i].unit == Unit::ALU) != (OPCODES[i].operation != ALUOpcode::COUNT) ||
+            (OPCODES[i].unit == Unit::ALU && ALU_MNEMONICS[static_cast<uint8_t>(OPCODES[i].operation)] != OPCODES[i].mnemonic)) {
+            return false;
+        }
+    }
+    return true;
+}(), "every ALU opcode must name the ALU operation of the same mnemonic");
+
+static_assert([] {
+    for (const OpcodeInfo& info : OPCODES) {
+        if (info.short_form != Opcode::COUNT) {
+            const OpcodeInfo& relaxed = OPCODES[static_cast<uint8_t>(info.short_form)];
+
+            if (info.format != Format::J16 || relaxed.format != Format::J8 || relaxed.mnemonic != info.mnemonic || relaxed.condition != info.condition) {
+                return false;
+            }
+        }
+    }
+    return true;
+}(), "the short form of a branch must be the J8 encoding of the same J16 branch");
+
+// Description of an opcode.
+constexpr const OpcodeInfo& opcode_info(const Opcode opcode) noexcept { return OPCODES[static_cast<uint8_t>(opcode)]; }
+
+// Layout of an opcode's format.
+constexpr const FormatInfo& format_info(const Opcode opcode) noexcept { return FORMATS[static_cast<uint8_t>(opcode_info(opcode).format)]; }
+
+// Encoded size in bytes of an instruction with the given opcode.
+constexpr uint8_t instruction_size(const Opcode opcode) noexcept { return format_info(opcode).size; }
+
+/*
+A decoded instruction: its opcode and raw operand values in assembly operand order.
+*/
+struct Instruction {
+    Opcode opcode = Opcode::COUNT;
+    std::array<uint16_t, 4> operands = {};
+};
+
+/*
+ORs `operand`, truncated to FIELD, into its bytes of the encoding at `out`.
+*/
+template <OperandField FIELD>
+constexpr void ENCODE_FIELD(const uint16_t operand, uint8_t* const out) noexcept {
+    const uint32_t value = (operand & ((1u << FIELD.bits) - 1)) << FIELD.shift;
+
+    for (uint8_t byte = 0; byte * 8 < FIELD.shift + FIELD.bits; byte++) {
+        out[FIELD.byte + byte] |= static_cast<uint8_t>(value >> 8 * byte);
+    }
+}
+
+/*
+Writes the encoding of `instruction` in format F to `out`, which must hold FORMATS[F].size bytes.
+Expanded per field at compile time, so each format compiles to a few shifts and stores.
+*/
+template <Format F>
+constexpr void ENCODE(const Instruction& instruction, uint8_t* const out) noexcept {
+    constexpr FormatInfo FORMAT = FORMATS[static_cast<uint8_t>(F)];
+    out[0] = static_cast<uint8_t>(instruction.opcode);
+
+    for (uint8_t i = 1; i < FORMAT.size; i++) {
+        out[i] = 0;
+    }
+    [&]<size_t... I>(std::index_sequence<I...>) {
+        (ENCODE_FIELD<FORMAT.operands[I]>(instruction.operands[I], out), ...);
+    }(std::make_index_sequence<FORMAT.operand_count>{});
+}
+
+/*
+Writes the encoding of `instruction` to `out`, which must hold instruction_size(opcode) bytes.
+Operand values are truncated to their fields.
+*/
+constexpr void encode(const Instruction& instruction, uint8_t* const out) noexcept {
+    switch (opcode_info(instruction.opcode).format) {
+        case Format::R:
+            return ENCODE<Format::R>(instruction, out);
+        case Format::RR:
+            return ENCODE<Format::RR>(instruction, out);
+        case Format::RI:
+            return ENCODE<Format::RI>(instruction, out);
+        case Format::RC:
+            return ENCODE<Format::RC>(instruction, out);
+        case Format::RRRR:
+            return ENCODE<Format::RRRR>(instruction, out);
+        case Format::J8:
+            return ENCODE<Format::J8>(instruction, out);
+        case Format::J16:
+            return ENCODE<Format::J16>(instruction, out);
+        case Format::NONE:
+            return ENCODE<Format::NONE>(instruction, out);
+    }
+}
+
+/*
+Decodes the instruction at the start of `code` (`size` readable bytes) with one OPCODES lookup.
+
+Returns:
+- The encoded size in bytes, or 0 if the opcode byte is invalid or the instruction is truncated.
+*/
+constexpr uint8_t decode(const uint8_t* const code, const size_t size, Instruction& instruction) noexcept {
+    if (size == 0 || code[0] >= static_cast<uint8_t>(Opcode::COUNT) || size < instruction_size(static_cast<Opcode>(code[0]))) {
+        return 0;
+    }
+    instruction.opcode = static_cast<Opcode>(code[0]);
+    const FormatInfo& format = format_info(instruction.opcode);
+
+    for (uint8_t i = 0; i < format.operand_count; i++) {
+        const OperandField& field = format.operands[i];
+        uint32_t value = 0;
+
+        for (uint8_t byte = 0; byte * 8 < field.shift + field.bits; byte++) {
+            value |= static_cast<uint32_t>(code[field.byte + byte]) << 8 * byte;
+        }
+        instruction.operands[i] = static_cast<uint16_t>(value >> field.shift & ((1u << field.bits) - 1));
+    }
+    return format.size;
+}
+
+/*
+Formats `instruction` as assembly, e.g. `MAC r2, r3, r0, r1` or `MOV r0, 50`, which assembles
+back to the same encoding.
+
+Parameters:
+- address: Address of the instruction; a short branch prints its absolute target, which
+  assembles back to the same branch (in the short form when the target is in reach).
+*/
+constexpr std::string disassemble(const Instruction& instruction, const uint32_t address = 0) {
+    const OpcodeInfo& info = opcode_info(instruction.opcode);
+    const FormatInfo& format = format_info(instruction.opcode);
+    std::string text(info.mnemonic);
+
+    for (uint8_t i = 0; i < format.operand_count; i++) {
+        char digits[6] = {};
+        char* start = digits + std::size(digits);
+        uint16_t value = instruction.operands[i];
+
+        if (format.operands[i].kind == OperandKind::RELATIVE) {
+            value = static_cast<uint16_t>(address + format.size + static_cast<int8_t>(value));
+        }
+
+        do {
+            *--start = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value);
+
+        text += i ? ", " : " ";
+        text += format.operands[i].kind == OperandKind::REGISTER ? "r" : "";
+        text.append(start, digits + std::size(digits));
+    }
+    return text;
+}
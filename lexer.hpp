@@ -0,0 +1,173 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "character_classifier.hpp"
+
+/*
+Token categories produced by the Lexer.
+*/
+enum class TokenKind : uint8_t { IDENTIFIER, NUMBER, PUNCTUATOR, NEWLINE, END };
+
+/*
+A lexical token. `text` views into the source buffer, so the source has to outlive its tokens.
+*/
+struct Token {
+    TokenKind kind = TokenKind::END;
+    std::string_view text;
+    uint32_t line = 1; // 1-based source line the token starts on
+};
+
+/*
+Lexer
+
+Splits assembly source into tokens without copying: every token is a view into the source.
+Follows separation of concerns (SOC): only tokenization here, no knowledge of mnemonics or registers.
+Each 64-byte block is classified once (CharacterClassifier) into bitmaps of token starts and
+identifier delimiters; finding the next token or the end of an identifier is then a
+count-trailing-zeros on a bitmap instead of a byte-at-a-time state machine.
+
+Lexical grammar:
+- IDENTIFIER: [A-Za-z_.$][A-Za-z0-9_.$]*   (mnemonics, registers, labels)
+- NUMBER:     [0-9][A-Za-z0-9_.$]*          (validated by the consumer: 42, 0x2A, 0b101010)
+- NEWLINE:    '\n' (statements are line-terminated)
+- PUNCTUATOR: any other single non-blank character (',', ':', '-', ...)
+- Blanks (' ', '\t', '\r') separate tokens; ';' starts a comment running to the end of the line.
+*/
+class Lexer {
+public:
+    // `line` is the number of the source's first line, for a source that continues an earlier one.
+    constexpr explicit Lexer(const std::string_view source, const uint32_t line = 1) noexcept : source(source), line(line) {
+        if (!source.empty()) {
+            load(0);
+        }
+    }
+
+    /*
+    Returns the next token, or an END token once the source is exhausted.
+    */
+    constexpr Token next() noexcept {
+        size_t start;
+
+        for (;;) {
+            while (!pending) {
+                if (block + CharacterClassifier::BLOCK >= source.size()) {
+                    return {TokenKind::END, {source.data() + source.size(), 0}, line};
+                }
+                load(block + CharacterClassifier::BLOCK);
+            }
+            start = block + std::countr_zero(pending);
+
+            if (source[start] != ';') {
+                break;
+            }
+            seek(find<&Lexer::newlines>(start));
+        }
+        const TokenKind kind = FIRST_BYTE_KIND[static_cast<uint8_t>(source[start])];
+
+        if (kind == TokenKind::NEWLINE || kind == TokenKind::PUNCTUATOR) {
+            pending &= pending - 1;
+            return {kind, {source.data() + start, 1}, kind == TokenKind::NEWLINE ? line++ : line};
+        }
+        const size_t end = find<&Lexer::delimiters>(start + 1);
+        seek(end);
+        return {kind, {source.data() + start, end - start}, line};
+    }
+
+private:
+    std::string_view source;
+    uint32_t line = 1;
+    size_t block = 0; // Offset of the classified block
+    uint64_t starts = 0; // Bytes that begin a token: non-blank and not inside an identifier run
+    uint64_t delimiters = 0; // Bytes that end an identifier or number: not identifier characters
+    uint64_t newlines = 0; // '\n' bytes, to end comments
+    uint64_t pending = 0; // Token starts of the current block not yet returned
+
+    /*
+    Classifies the 64-byte block starting at `start` and makes all of its token starts pending.
+    The final partial block is classified from a zero-padded copy, and bytes past the end are masked out.
+    */
+    constexpr void load(const size_t start) noexcept {
+        block = start;
+        const size_t valid = source.size() - start;
+        CharacterMasks masks;
+
+        if (valid >= CharacterClassifier::BLOCK) {
+            masks = CharacterClassifier::classify(source.data() + start);
+        } else {
+            char tail[CharacterClassifier::BLOCK] = {};
+
+            for (size_t i = 0; i < valid; i++) {
+                tail[i] = source[start + i];
+            }
+            masks = CharacterClassifier::classify(tail);
+        }
+        const uint64_t in_range = valid >= CharacterClassifier::BLOCK ? ~uint64_t(0) : (uint64_t(1) << valid) - 1;
+        const uint64_t carry = start && is_identifier_continue(source[start - 1]);
+        starts = ~masks.blank & ~(masks.identifier & (masks.identifier << 1 | carry)) & in_range;
+        delimiters = ~masks.identifier | ~in_range; // Bits past the end stop runs at the source size
+        newlines = masks.newline;
+        pending = starts;
+    }
+
+    /*
+    Continues lexing at `offset`: drops the pending token starts before it, classifying its block first
+    if the offset lies beyond the current one.
+    */
+    constexpr void seek(const size_t offset) noexcept {
+        if (offset - block >= CharacterClassifier::BLOCK) {
+            if (offset >= source.size()) {
+                pending = 0;
+                block = source.size();
+                return;
+            }
+            load(offset & ~(CharacterClassifier::BLOCK - 1));
+        }
+        pending = starts & (~uint64_t(0) << (offset - block));
+    }
+
+    /*
+    Returns the first offset at or after `offset` whose bit is set in the MASK of its block, or the
+    source size if there is none. Bits are only ever set up to the source size.
+    */
+    template <uint64_t Lexer::* MASK>
+    constexpr size_t find(size_t offset) noexcept {
+        while (offset < source.size()) {
+            if (offset - block >= CharacterClassifier::BLOCK) {
+                load(offset & ~(CharacterClassifier::BLOCK - 1));
+            }
+            const uint64_t bits = this->*MASK >> (offset - block);
+
+            if (bits) {
+                return offset + std::countr_zero(bits);
+            }
+            offset = block + CharacterClassifier::BLOCK;
+        }
+        return source.size();
+    }
+
+    // Kind of the token a byte starts (blanks and ';' never start one)
+    static constexpr auto FIRST_BYTE_KIND = [] {
+        std::array<TokenKind, 256> table{};
+
+        for (int c = 0; c < 256; c++) {
+            if (c == '\n') {
+                table[c] = TokenKind::NEWLINE;
+            } else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '.' || c == '$') {
+                table[c] = TokenKind::IDENTIFIER;
+            } else if (c >= '0' && c <= '9') {
+                table[c] = TokenKind::NUMBER;
+            } else {
+                table[c] = TokenKind::PUNCTUATOR;
+            }
+        }
+        return table;
+    }();
+
+    static constexpr bool is_identifier_continue(const char c) noexcept {
+        const TokenKind kind = FIRST_BYTE_KIND[static_cast<uint8_t>(c)];
+        return kind == TokenKind::IDENTIFIER || kind == TokenKind::NUMBER;
+    }
+};
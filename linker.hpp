@@ -0,0 +1,202 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "isa.hpp"
+#include "object.hpp"
+
+/*
+Linker
+
+Combines relocatable Objects into one executable image.
+
+Steps:
+- Symbol resolution: defined global symbols are entered into a hash index by name; a second
+  definition of the same name is an error.
+- Section garbage collection (optional): starting from the entry section (the first section of the
+  first object, which the CPU starts executing at address 0), sections are marked live through a
+  worklist by following the relocations inside live sections to the sections defining their
+  symbols. Unmarked sections are dropped from the image. Only references count: execution falling
+  through from the end of one section into the next does not keep the next one alive.
+- Layout: live sections are placed back to back in object order, then section order, each start
+  rounded up to the section's alignment; the gaps are zero.
+- Relocation: each relocated imm16 in a live section receives its symbol's final address (the new
+  base of the defining section plus the symbol's offset within it, found directly for local
+  symbols and through the index for imports) plus the addend the field already holds, modulo
+  2^ARCHITECTURE.
+
+Errors:
+- Collected as messages in `errors` (duplicate or undefined symbols, addresses beyond the
+  ARCHITECTURE-bit address space), once per symbol and object; linking continues so every error is
+  reported. References from discarded sections are never resolved, so they cannot fail.
+*/
+class Linker {
+public:
+    std::vector<uint8_t> image; // Linked code of the last link() call
+    std::vector<std::string> errors; // Errors of the last link() call
+    size_t discarded_sections = 0; // Sections dropped by the last link() call
+    size_t discarded_bytes = 0; // Code bytes dropped by the last link() call
+
+    /*
+    Links `objects` into `image`, replacing the output of any previous call.
+
+    Parameters:
+    - gc_sections: drop sections unreachable from the entry section.
+
+    Returns:
+    - true when every symbol resolved.
+    */
+    bool link(const std::vector<Object>& objects, const bool gc_sections = false) {
+        image.clear();
+        errors.clear();
+        globals.clear();
+        first_section.assign(1, 0);
+
+        for (size_t i = 0; i < objects.size(); i++) {
+            first_section.push_back(first_section.back() + static_cast<uint32_t>(objects[i].sections.size()));
+
+            for (uint32_t s = 0; s < objects[i].symbols.size(); s++) {
+                const ObjectSymbol& symbol = objects[i].symbols[s];
+
+                if (symbol.defined && symbol.global) {
+                    const auto [entry, inserted] = globals.try_emplace(symbol.name, Definition{static_cast<uint32_t>(i), s});
+
+                    if (!inserted) {
+                        errors.push_back(objects[i].name + ": duplicate symbol '" + symbol.name + "' (first defined in " +
+                                         objects[entry->second.object].name + ")");
+                    }
+                }
+            }
+        }
+        live.assign(first_section.back(), !gc_sections);
+        bases.assign(first_section.back(), 0);
+
+        if (gc_sections && !objects.empty() && !objects[0].sections.empty()) {
+            mark(objects);
+        }
+        uint32_t size = 0;
+        discarded_sections = 0;
+        discarded_bytes = 0;
+
+        for (size_t i = 0; i < objects.size(); i++) {
+            for (size_t s = 0; s < objects[i].sections.size(); s++) {
+                const Section& section = objects[i].sections[s];
+
+                if (live[first_section[i] + s]) {
+                    size = (size + section.alignment - 1) & ~(section.alignment - 1);
+                    bases[first_section[i] + s] = size;
+                    size += section.size;
+                } else {
+                    discarded_sections++;
+                    discarded_bytes += section.size;
+                }
+            }
+        }
+        image.resize(size);
+
+        for (size_t i = 0; i < objects.size(); i++) {
+            const Object& object = objects[i];
+            reported.assign(object.symbols.size(), false);
+            size_t s = 0;
+
+            for (; s < object.sections.size(); s++) {
+                if (live[first_section[i] + s] && object.sections[s].size) {
+                    std::memcpy(image.data() + bases[first_section[i] + s], object.code.data() + object.sections[s].offset, object.sections[s].size);
+                }
+            }
+            s = 0;
+
+            for (const Relocation& relocation : object.relocations) {
+                while (relocation.offset >= object.sections[s].offset + object.sections[s].size) {
+                    s++;
+                }
+                if (!live[first_section[i] + s]) {
+                    continue;
+                }
+                const ObjectSymbol& symbol = object.symbols[relocation.symbol];
+                uint32_t address = UINT32_MAX;
+
+                if (symbol.defined) {
+                    address = ADDRESS(objects, static_cast<uint32_t>(i), relocation.symbol);
+                } else if (const auto entry = globals.find(symbol.name); entry != globals.end()) {
+                    address = ADDRESS(objects, entry->second.object, entry->second.symbol);
+                }
+                if (address >= ADDRESS_SPACE) {
+                    if (!reported[relocation.symbol]) {
+                        reported[relocation.symbol] = true;
+                        errors.push_back(object.name + ": " +
+                                         (address == UINT32_MAX ? "undefined symbol '" + symbol.name + "'"
+                                                                : "symbol '" + symbol.name + "' lies beyond the " + std::to_string(ARCHITECTURE) + "-bit address space"));
+                    }
+                    continue;
+                }
+                const uint32_t at = bases[first_section[i] + s] + relocation.offset - object.sections[s].offset;
+                const uint16_t word = static_cast<uint16_t>(address + (image[at] | image[at + 1] << 8));
+                image[at] = static_cast<uint8_t>(word);
+                image[at + 1] = static_cast<uint8_t>(word >> 8);
+            }
+        }
+        return errors.empty();
+    }
+
+private:
+    static constexpr uint32_t ADDRESS_SPACE = 1u << ARCHITECTURE;
+
+    struct Definition {
+        uint32_t object; // Index of the defining object
+        uint32_t symbol; // Index of the symbol in that object
+    };
+
+    std::unordered_map<std::string_view, Definition> globals; // Views into the linked objects' symbol names
+    std::vector<uint32_t> first_section; // Flat index of each object's first section; one extra entry holds the total
+    std::vector<bool> live; // Per flat section index
+    std::vector<uint32_t> bases; // Per flat section index: address in the image, if live
+    std::vector<bool> reported; // Symbols of the current object already reported as unresolvable
+
+    /*
+    Marks every section reachable from the entry section through relocations.
+    */
+    void mark(const std::vector<Object>& objects) {
+        std::vector<std::pair<uint32_t, uint32_t>> worklist; // (object, section)
+        const auto visit = [&](const uint32_t object, const uint32_t section) {
+            if (!live[first_section[object] + section]) {
+                live[first_section[object] + section] = true;
+                worklist.emplace_back(object, section);
+            }
+        };
+        visit(0, 0);
+
+        while (!worklist.empty()) {
+            const auto [o, s] = worklist.back();
+            worklist.pop_back();
+            const Object& object = objects[o];
+            const Section& section = object.sections[s];
+            const auto first = std::lower_bound(object.relocations.begin(), object.relocations.end(), section.offset,
+                                                [](const Relocation& relocation, const uint32_t offset) { return relocation.offset < offset; });
+
+            for (auto relocation = first; relocation != object.relocations.end() && relocation->offset < section.offset + section.size; ++relocation) {
+                const ObjectSymbol& symbol = object.symbols[relocation->symbol];
+
+                if (symbol.defined) {
+                    visit(o, symbol.section);
+                } else if (const auto entry = globals.find(symbol.name); entry != globals.end()) {
+                    visit(entry->second.object, objects[entry->second.object].symbols[entry->second.symbol].section);
+                }
+            }
+        }
+    }
+
+    /*
+    Final address of symbol `symbol` defined in object `object`, or beyond the address space if
+    its section was discarded.
+    */
+    uint32_t ADDRESS(const std::vector<Object>& objects, const uint32_t object, const uint32_t symbol) const noexcept {
+        const ObjectSymbol& definition = objects[object].symbols[symbol];
+        const uint32_t section = first_section[object] + definition.section;
+        return live[section] ? bases[section] + definition.value - objects[object].sections[definition.section].offset : UINT32_MAX - 1;
+    }
+};
@@ -0,0 +1,195 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include "isa.hpp"
+#include "peephole.hpp"
+
+/*
+Listing
+
+Formats an assembled source as a listing, one row per instruction, with the static cycle
+estimates of the CostModel, so hot spots show before the program runs:
+
+     addr  code         cycles  instruction         source
+     0000  01 00 0a 00       1  MOV r0, 10          MOV r0, 10
+                                ; block 0000-0004: 1 instruction, 1 cycle
+     0004  02 10             1  ADD r1, r0          loop: ADD r1, r0
+     0006  08 00             1  DEC r0              DEC r0
+     0008  15 fa             1  JNZ 4               JNZ loop
+                                ; block 0004-000a: 3 instructions, 3 cycles
+     000a  01 02 64 00       1  MOV r2, 100         MOV r2, 100
+     000e  06 20        131074  DIV r2, r0          DIV r2, r0
+     0010  22                1  HLT                 HLT
+                                ; block 000a-0011: 3 instructions, 131076 cycles
+
+Rows:
+- Every source line is listed in order; its code follows the Assembler's `origins` (see
+  Assembler::trace), so a macro invocation lists its whole expansion and a line the Peephole
+  rewrote lists the instructions that replaced it. The instruction column disassembles the code.
+- Data (.byte, .word, .fill, .align, .incbin) is listed DATA_WIDTH bytes per row, at most
+  DATA_ROWS rows per line, without cycles.
+
+Cycles:
+- The modeled cycles of each instruction in its worst case (the OpcodeInfo cost): data-dependent
+  operations assume their most expensive operands, e.g. DIV the largest quotient and MUL a
+  multiplier of all ones. ROL and ROR take their step count from the immediate.
+- Blocks are the straight-line runs of code: one starts at a label and after a branch, HLT or
+  data, and its total is listed once it ends. A block runs once per entry, so the total is the
+  cost of one pass, not a profile (see Interpreter `cycles` for measured costs).
+*/
+class Listing {
+public:
+    static constexpr uint8_t DATA_WIDTH = 4; // Data bytes per row
+    static constexpr uint8_t DATA_ROWS = 4; // Data rows per line before the rest is summarized
+
+    /*
+    Writes the listing of `source`, assembled into `code` with the Assembler's `origins`, to `os`.
+    */
+    static void write(auto& os, const std::string_view source, const std::span<const uint8_t> code, const std::span<const Origin> origins) {
+        Block block;
+        size_t next = 0; // Next origin to list
+        size_t start = 0; // Start of the current line in `source`
+        ROW(os, ' ' + PAD("addr", 4) + "  " + PAD("code", CODE_WIDTH) + ' ' + PAD("cycles", 6, true) + "  instruction", "source");
+
+        for (uint32_t line = 1; start < source.size(); line++) {
+            size_t end = source.find('\n', start);
+            end = end == std::string_view::npos ? source.size() : end;
+            std::string_view text = source.substr(start, end - start);
+            text = text.ends_with('\r') ? text.substr(0, text.size() - 1) : text;
+            start = end + 1;
+            bool listed = false; // The source text is on a row already
+
+            for (; next < origins.size() && origins[next].line == line; next++) {
+                const Origin& origin = origins[next];
+                const uint32_t until = next + 1 < origins.size() ? origins[next + 1].offset : static_cast<uint32_t>(code.size());
+
+                if (origin.entry || origin.data) {
+                    block.close(os);
+                }
+                if (origin.offset == until && origin.entry && !listed) {
+                    ROW(os, ' ' + ADDRESS(origin.offset), text);
+                    listed = true;
+                }
+                if (origin.data) {
+                    list_data(os, code, origin.offset, until, listed ? std::string_view() : text);
+                    listed = true;
+                    continue;
+                }
+                for (uint32_t offset = origin.offset; offset < until;) {
+                    Instruction instruction;
+                    const uint8_t size = decode(code.data() + offset, until - offset, instruction);
+
+                    if (!size) { // Not an instruction after all: list the rest as data
+                        block.close(os);
+                        list_data(os, code, offset, until, listed ? std::string_view() : text);
+                        listed = true;
+                        break;
+                    }
+                    const uint32_t cycles = CYCLES(instruction);
+                    std::string encoding;
+
+                    for (uint8_t i = 0; i < size; i++) {
+                        encoding += HEX(code[offset + i]);
+                        encoding += i + 1 < size ? " " : "";
+                    }
+                    block.add(offset, size, cycles);
+                    ROW(os, ' ' + ADDRESS(offset) + "  " + PAD(encoding, CODE_WIDTH) + ' ' + PAD(std::to_string(cycles), 6, true) + "  " + disassemble(instruction, offset),
+                        listed ? std::string_view() : text);
+                    listed = true;
+                    offset += size;
+
+                    if (opcode_info(instruction.opcode).unit == Unit::CONTROL) {
+                        block.close(os);
+                    }
+                }
+            }
+            if (!listed) {
+                ROW(os, "", text);
+            }
+        }
+        block.close(os);
+    }
+
+    /*
+    Worst-case modeled cycles of `instruction` (see Cycles).
+    */
+    static constexpr uint32_t CYCLES(const Instruction& instruction) noexcept {
+        if (instruction.opcode == Opcode::ROL || instruction.opcode == Opcode::ROR) {
+            return CostModel::ROTATE(static_cast<uint8_t>(instruction.operands[1])).cycles;
+        }
+        return opcode_info(instruction.opcode).cost.cycles;
+    }
+
+private:
+    static constexpr size_t CODE_WIDTH = 12; // Four encoded bytes and their blanks
+    static constexpr size_t INSTRUCTION_WIDTH = 20;
+    static constexpr size_t TOTAL_COLUMN = 1 + 4 + 2 + CODE_WIDTH + 1 + 6 + 2; // Where block totals start, under the instructions
+    static constexpr size_t SOURCE_COLUMN = TOTAL_COLUMN + INSTRUCTION_WIDTH;
+
+    /*
+    Instructions and cycles of the block being listed.
+    */
+    struct Block {
+        uint32_t begin = 0;
+        uint32_t end = 0;
+        uint32_t instructions = 0;
+        uint64_t cycles = 0;
+
+        constexpr void add(const uint32_t offset, const uint8_t size, const uint32_t cost) noexcept {
+            begin = instructions ? begin : offset;
+            end = offset + size;
+            instructions++;
+            cycles += cost;
+        }
+
+        // Lists the total of the block, if it has instructions, and starts the next one.
+        void close(auto& os) {
+            if (instructions) {
+                os << std::string(TOTAL_COLUMN, ' ') << "; block " << ADDRESS(begin) << '-' << ADDRESS(end) << ": " << instructions
+                   << (instructions == 1 ? " instruction, " : " instructions, ") << cycles << (cycles == 1 ? " cycle\n" : " cycles\n");
+            }
+            *this = {};
+        }
+    };
+
+    // Lists code[offset, until) as data, the first row with `text`.
+    static void list_data(auto& os, const std::span<const uint8_t> code, const uint32_t offset, const uint32_t until, const std::string_view text) {
+        for (uint32_t row = offset, rows = 0; row < until; row += DATA_WIDTH, rows++) {
+            if (rows == DATA_ROWS) {
+                os << ' ' << ADDRESS(row) << "  ... " << until - row << " more bytes\n";
+                return;
+            }
+            std::string encoding;
+
+            for (uint32_t i = row; i < until && i < row + DATA_WIDTH; i++) {
+                encoding += HEX(code[i]);
+                encoding += i + 1 < until && i + 1 < row + DATA_WIDTH ? " " : "";
+            }
+            ROW(os, ' ' + ADDRESS(row) + "  " + encoding, row == offset ? text : std::string_view());
+        }
+    }
+
+    // Lists a row: `columns`, then `text` in the source column.
+    static void ROW(auto& os, const std::string& columns, const std::string_view text) {
+        os << (text.empty() ? columns : PAD(columns, SOURCE_COLUMN)) << text << '\n';
+    }
+
+    // `value` as two lowercase hex digits.
+    static constexpr std::string HEX(const uint8_t value) {
+        constexpr char DIGITS[] = "0123456789abcdef";
+        return {DIGITS[value >> 4], DIGITS[value & 0xF]};
+    }
+
+    // `offset` as four hex digits, or six beyond the 16-bit address space.
+    static constexpr std::string ADDRESS(const uint32_t offset) {
+        return (offset >> 16 ? HEX(static_cast<uint8_t>(offset >> 16)) : "") + HEX(static_cast<uint8_t>(offset >> 8)) + HEX(static_cast<uint8_t>(offset));
+    }
+
+    // `text` padded with blanks to `width` characters, on the left when `right` aligned.
+    static constexpr std::string PAD(std::string text, const size_t width, const bool right = false) {
+        const size_t blanks = text.size() < width ? width - text.size() : 0;
+        return right ? std::string(blanks, ' ') + text : text + std::string(blanks, ' ');
+    }
+};
@@ -26,6 +26,8 @@ int main() {
     alu.ADD(regs[3], regs[1]);
     std::cout << "\nADD test:\n";
     std::cout << "reg3 = reg0 + reg1 = " << static_cast<int16_t>(regs[3]) << std::endl;
+    alu.ADD<Fidelity::LOOKUP>(regs[3], regs[0]);
+    std::cout << "reg3 + reg0 (byte-slice lookup) = " << static_cast<int16_t>(regs[3]) << std::endl;
 
     // SUB test
     alu.SUB(regs[4], regs[0]);
@@ -46,14 +48,33 @@ int main() {
     std::cout << "\nMUL test:\n";
     std::cout << "6 * 7 = " << static_cast<int16_t>(regs[6]) << std::endl;
 
+    // MAC test (accumulator pair reg8:reg9)
+    LSU::MOV(regs[8], 0);
+    LSU::MOV(regs[9], 1000);
+    LSU::MOV(regs[6], 300);
+    LSU::MOV(regs[7], -250);
+    alu.MAC(regs[8], regs[9], regs[6], regs[7]);
+    alu.MAC<Fidelity::NATIVE>(regs[8], regs[9], regs[6], regs[6]);
+    std::cout << "\nMAC test:\n";
+    std::cout << "1000 + 300 * -250 + 300 * 300 = "
+              << static_cast<int32_t>(static_cast<DWORD>(static_cast<WORD>(regs[8])) << ARCHITECTURE | static_cast<WORD>(regs[9])) << std::endl;
+
+    // MULH test: upper half of the unsigned product
+    LSU::MOV(regs[10], 50000);
+    LSU::MOV(regs[11], 3000);
+    alu.MULH(regs[10], regs[11]);
+    std::cout << "\nMULH test:\n";
+    std::cout << "(50000 * 3000) >> 16 = " << static_cast<WORD>(regs[10]) << std::endl;
+
     // DIV test
     LSU::MOV(regs[8], 42);
     LSU::MOV(regs[9], 4);
 
-    alu.DIV(regs[8], regs[9], regs[14], regs[15], regs[13]);
+    alu.DIV(regs[8], regs[9], regs[13], temp, zero);
 
     std::cout << "\nDIV test:\n";
-    std::cout << "42 / 7 = " << static_cast<int16_t>(regs[8]) << std::endl;
+    std::cout << "42 / 4 = " << static_cast<int16_t>(regs[8]) << std::endl;
+    std::cout << "DIV cost: " << alu.cost.cycles << " cycles, depth " << alu.cost.depth << std::endl;
 
 
     // SHL / SHR / SAR test
@@ -85,6 +106,24 @@ int main() {
     std::cout << "\nCMP test:\n";
     std::cout << "CMP reg12 and reg13 -> ZF: " << static_cast<bool>(alu.ZF) << ", SF: " << static_cast<bool>(alu.SF) << std::endl;
 
+    // execute dispatch test
+    LSU::MOV(regs[0], 20);
+    LSU::MOV(regs[1], 22);
+    alu.execute(ALUOpcode::ADD, {.lhs = &regs[0], .rhs = &regs[1]});
+    std::cout << "\nexecute test:\n";
+    std::cout << "execute(ADD, 20, 22) = " << static_cast<int16_t>(regs[0]) << std::endl;
+
+    // CHECKED fidelity test: native evaluation cross-checked against the gate model
+    ALU<Fidelity::CHECKED> checked;
+    checked.checker.sample_interval = 1;
+    LSU::MOV(regs[0], 1234);
+    LSU::MOV(regs[1], 56);
+    checked.DIV(regs[0], regs[1], regs[13], temp, zero);
+    checked.DEC(regs[0]);
+    std::cout << "\nCHECKED test:\n";
+    std::cout << "1234 / 56 - 1 = " << static_cast<int16_t>(regs[0]) << " (" << checked.checker.samples << " samples, "
+              << checked.checker.divergences.size() << " divergences)" << std::endl;
+
     // Final flags
     std::cout << "\nFinal Flags:\n";
     std::cout << "ZF: " << static_cast<bool>(alu.ZF) << ", SF: " << static_cast<bool>(alu.SF) << ", CF: " << static_cast<bool>(alu.CF)
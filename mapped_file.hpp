@@ -0,0 +1,125 @@
+#pragma once
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+MappedFile
+
+Read-only memory mapping of a whole file (POSIX mmap), exposed as a string_view so the Lexer can
+tokenize it in place: no read buffer, no per-line copies.
+
+Memory:
+- The mapping is advised MADV_SEQUENTIAL, so the kernel reads ahead and reclaims pages behind the
+  lexer; pages are clean and file-backed, so resident memory stays bounded by the page cache rather
+  than growing with the file size.
+- Views into the mapping (tokens, label names) stay valid until the MappedFile is destroyed.
+
+Errors:
+- A file that cannot be opened, stat'ed or mapped yields an invalid MappedFile (operator bool is
+  false) with the failing errno in `error`. An empty file maps to an empty, valid view.
+*/
+class MappedFile {
+public:
+    int error = 0; // errno of the failed open/fstat/mmap, 0 on success
+
+    explicit MappedFile(const char* path) noexcept {
+        const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+
+        if (fd < 0) {
+            error = errno;
+            return;
+        }
+        struct stat info {};
+
+        if (::fstat(fd, &info) != 0) {
+            error = errno;
+        } else if (info.st_size > 0) {
+            void* mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (mapping == MAP_FAILED) {
+                error = errno;
+            } else {
+                ::madvise(mapping, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+                data = static_cast<const char*>(mapping);
+                size = static_cast<size_t>(info.st_size);
+            }
+        }
+        ::close(fd);
+    }
+
+    MappedFile(MappedFile&& other) noexcept
+        : error(other.error), data(std::exchange(other.data, nullptr)), size(std::exchange(other.size, 0)) {}
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        std::swap(error, other.error);
+        std::swap(data, other.data);
+        std::swap(size, other.size);
+        return *this;
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() noexcept {
+        if (data) {
+            ::munmap(const_cast<char*>(data), size);
+        }
+    }
+
+    explicit operator bool() const noexcept { return error == 0; }
+
+    /*
+    Drops the pages holding the first `size` bytes (whole pages only) from memory; they are read
+    from the file again if touched.
+    */
+    void release(const size_t size) const noexcept {
+        const size_t length = std::min(size, this->size) & ~(static_cast<size_t>(::sysconf(_SC_PAGESIZE)) - 1);
+
+        if (length) {
+            ::madvise(const_cast<char*>(data), length, MADV_DONTNEED);
+        }
+    }
+
+    std::string_view view() const noexcept { return {data, size}; }
+
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+};
+
+/*
+Appends the contents of the file at `path` to `out` (an Assembler FileLoader, for `.incbin`).
+The file is mapped and copied in windows, each released once copied, so only the copy in `out`
+stays resident: the file is never buffered on the side.
+
+Returns:
+- an empty string on success, else the reason the file could not be read.
+*/
+inline std::string append_file(const std::string_view path, std::vector<uint8_t>& out) {
+    constexpr size_t WINDOW = 1 << 20;
+    const MappedFile file(std::string(path).c_str());
+
+    if (!file) {
+        return std::strerror(file.error);
+    }
+    const std::string_view bytes = file.view();
+    out.reserve(out.size() + bytes.size());
+
+    for (size_t offset = 0; offset < bytes.size(); offset += WINDOW) {
+        const std::string_view window = bytes.substr(offset, WINDOW);
+        out.insert(out.end(), window.begin(), window.end());
+        file.release(offset + window.size());
+    }
+    return {};
+}
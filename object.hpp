@@ -0,0 +1,188 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+A contiguous range of an Object's code, started by a `.section <name>` directive. Sections are the
+unit the Linker keeps or discards.
+*/
+struct Section {
+    std::string name;
+    uint32_t offset = 0; // Start in the object's code; sections are back to back in code order
+    uint32_t size = 0;
+    uint32_t alignment = 1; // Power of two the linked start must be a multiple of: the largest `.align` inside
+};
+
+/*
+A label of a relocatable Object.
+*/
+struct ObjectSymbol {
+    std::string name;
+    uint32_t value = 0; // Offset in the object's code, if defined
+    uint32_t section = 0; // Index of the defining section, if defined
+    uint32_t line = 0; // Source line of the definition, else of the first reference
+    bool defined = false;
+    bool global = false; // Visible to other objects; labels starting with '.' are file-local
+};
+
+/*
+An imm16 field of an Object whose final value is the address of a symbol plus the addend the field
+holds (0 for a bare label reference).
+*/
+struct Relocation {
+    uint32_t offset; // Offset of the imm16 field in the object's code
+    uint32_t symbol; // Index into Object::symbols
+};
+
+/*
+Relocatable object: the output of assembling one source file on its own.
+
+Label addresses are not known until the Linker places the object's sections in the image, so every
+imm16 that holds a label is left holding its addend and listed as a Relocation. Undefined global
+symbols are imports that another object has to define. Relocations are sorted by offset, and each
+field lies within one section.
+
+Serialized form (write_object / read_object), all integers LEB128 varints:
+    "CPUO" 0x02
+    section count, then per section: name length, name, size, alignment
+    code bytes (as many as the section sizes add up to)
+    symbol count, then per symbol: name length, name, value, section, line, flags (1 defined, 2 global)
+    relocation count, then per relocation: offset delta from the previous one, symbol
+*/
+struct Object {
+    std::string name; // Source name, for diagnostics; not serialized
+    std::vector<uint8_t> code;
+    std::vector<Section> sections;
+    std::vector<ObjectSymbol> symbols;
+    std::vector<Relocation> relocations;
+};
+
+constexpr std::string_view OBJECT_MAGIC = "CPUO\x02";
+
+/*
+Appends the serialized form of `object` to `out`.
+*/
+inline void write_object(const Object& object, std::vector<uint8_t>& out) {
+    const auto varint = [&](uint64_t value) {
+        for (; value >= 0x80; value >>= 7) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    };
+    const auto string = [&](const std::string_view text) {
+        varint(text.size());
+        out.insert(out.end(), text.begin(), text.end());
+    };
+    out.insert(out.end(), OBJECT_MAGIC.begin(), OBJECT_MAGIC.end());
+    varint(object.sections.size());
+
+    for (const Section& section : object.sections) {
+        string(section.name);
+        varint(section.size);
+        varint(section.alignment);
+    }
+    out.insert(out.end(), object.code.begin(), object.code.end());
+    varint(object.symbols.size());
+
+    for (const ObjectSymbol& symbol : object.symbols) {
+        string(symbol.name);
+        varint(symbol.value);
+        varint(symbol.section);
+        varint(symbol.line);
+        varint(symbol.defined | symbol.global << 1);
+    }
+    varint(object.relocations.size());
+    uint32_t previous = 0;
+
+    for (const Relocation& relocation : object.relocations) {
+        varint(relocation.offset - previous);
+        varint(relocation.symbol);
+        previous = relocation.offset;
+    }
+}
+
+/*
+Parses a serialized object from `bytes` into `object` (object.name is kept).
+
+Returns:
+- false if `bytes` is not a well-formed object.
+*/
+inline bool read_object(std::string_view bytes, Object& object) {
+    bool valid = bytes.starts_with(OBJECT_MAGIC);
+    bytes.remove_prefix(valid ? OBJECT_MAGIC.size() : bytes.size());
+
+    const auto varint = [&]() -> uint32_t {
+        uint64_t value = 0;
+
+        for (uint8_t shift = 0; valid; shift += 7) {
+            if (bytes.empty() || shift > 28) {
+                valid = false;
+                break;
+            }
+            const uint8_t byte = static_cast<uint8_t>(bytes.front());
+            bytes.remove_prefix(1);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+        valid &= value <= UINT32_MAX;
+        return static_cast<uint32_t>(value);
+    };
+    const auto string = [&]() {
+        const uint32_t size = varint();
+        valid &= size <= bytes.size();
+        const std::string_view text = bytes.substr(0, valid ? size : 0);
+        bytes.remove_prefix(text.size());
+        return std::string(text);
+    };
+    object.sections.resize(valid ? std::min<size_t>(varint(), bytes.size()) : 0);
+    uint64_t size = 0;
+
+    for (Section& section : object.sections) {
+        section.name = string();
+        section.offset = static_cast<uint32_t>(size);
+        section.size = varint();
+        section.alignment = varint();
+        size += section.size;
+        valid &= std::has_single_bit(section.alignment);
+    }
+    valid &= size <= bytes.size();
+    object.code.assign(bytes.begin(), bytes.begin() + (valid ? size : 0));
+    bytes.remove_prefix(object.code.size());
+    object.symbols.resize(valid ? std::min<size_t>(varint(), bytes.size()) : 0);
+
+    for (ObjectSymbol& symbol : object.symbols) {
+        symbol.name = string();
+        symbol.value = varint();
+        symbol.section = varint();
+        symbol.line = varint();
+        const uint32_t flags = varint();
+        symbol.defined = flags & 1;
+        symbol.global = flags & 2;
+        valid &= !symbol.defined || (symbol.section < object.sections.size() && symbol.value <= size);
+    }
+    object.relocations.resize(valid ? std::min<size_t>(varint(), bytes.size()) : 0);
+    uint64_t offset = 0;
+    uint64_t end = 0; // End of the previous relocation's field
+    size_t section = 0; // Section holding `offset`
+
+    for (Relocation& relocation : object.relocations) {
+        offset += varint();
+        relocation = {static_cast<uint32_t>(offset), varint()};
+
+        while (section < object.sections.size() && object.sections[section].offset + uint64_t(object.sections[section].size) <= offset) {
+            section++;
+        }
+        // Fields are ascending, do not overlap, and lie within one section, which the Linker patches in place
+        valid &= offset >= end && section < object.sections.size() && offset + 2 <= object.sections[section].offset + uint64_t(object.sections[section].size) &&
+                 relocation.symbol < object.symbols.size();
+        end = offset + 2;
+    }
+    return valid && bytes.empty();
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mapped_file.hpp"
+#include "object.hpp"
+
+/*
+ObjectCache
+
+Content-addressed on-disk store of assembled Objects, so rebuilding a many-file program re-assembles
+only the sources that changed and then relinks.
+
+Keys:
+- A 128-bit hash of the source bytes, the assembler environment (anything else that affects the
+  encoding, such as predefined macros) and CACHE_VERSION. Entries are never invalidated: a changed
+  source simply hashes to a new entry, and bumping CACHE_VERSION whenever the encoder or the object
+  format changes retires all old ones at once.
+- Only whole sources are cached, not single sections: labels are shared across the sections of a
+  file, so a section cannot be assembled on its own.
+
+Storage:
+- One serialized object (write_object) per entry, named by the key in hex. Entries are written to a
+  temporary file and renamed into place, so concurrent writers (parallel workers, parallel builds)
+  never expose a partial entry, and a corrupt or truncated entry reads as a miss.
+- Only sources that assembled without errors are stored, so diagnostics are always reproduced.
+*/
+class ObjectCache {
+public:
+    static constexpr std::string_view CACHE_VERSION = "cpu-assembler object cache 1";
+
+    int error = 0; // errno of creating the cache directory, 0 on success
+
+    /*
+    Opens the store in `directory`, creating the directory if needed.
+    */
+    explicit ObjectCache(std::string directory) : directory(std::move(directory)) {
+        if (::mkdir(this->directory.c_str(), 0777) != 0 && errno != EEXIST) {
+            error = errno;
+        }
+    }
+
+    explicit operator bool() const noexcept { return error == 0; }
+
+    /*
+    Loads the cached object of `source` into `object` (object.name is kept).
+
+    Returns:
+    - true on a hit; on a miss `object` is unspecified and has to be assembled.
+    */
+    bool load(const std::string_view source, const std::string_view environment, Object& object) const {
+        const MappedFile entry(PATH(source, environment).c_str());
+        return entry && read_object(entry.view(), object);
+    }
+
+    /*
+    Stores `object` as the assembled form of `source`; failures only cost a later miss.
+    */
+    void store(const std::string_view source, const std::string_view environment, const Object& object) const {
+        static std::atomic<uint32_t> counter = 0;
+        const std::string path = PATH(source, environment);
+        const std::string temporary = path + ".tmp" + std::to_string(::getpid()) + "." + std::to_string(counter++);
+        std::vector<uint8_t> bytes;
+        write_object(object, bytes);
+        const int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+
+        if (fd < 0) {
+            return;
+        }
+        size_t written = 0;
+
+        for (ssize_t result = 0; written < bytes.size(); written += static_cast<size_t>(result)) {
+            if ((result = ::write(fd, bytes.data() + written, bytes.size() - written)) <= 0) {
+                break;
+            }
+        }
+        if (::close(fd) != 0 || written != bytes.size() || ::rename(temporary.c_str(), path.c_str()) != 0) {
+            ::unlink(temporary.c_str());
+        }
+    }
+
+private:
+    std::string directory;
+
+    /*
+    Entry path of `source` in `environment`: the directory, then the 128-bit key as 32 hex digits.
+    */
+    std::string PATH(const std::string_view source, const std::string_view environment) const {
+        uint64_t key[2] = {0x9E3779B97F4A7C15, 0xC2B2AE3D27D4EB4F};
+        HASH(key, CACHE_VERSION);
+        HASH(key, environment);
+        HASH(key, source);
+        std::string path = directory + '/';
+
+        for (const uint64_t half : key) {
+            for (int shift = 60; shift >= 0; shift -= 4) {
+                path += "0123456789abcdef"[half >> shift & 0xF];
+            }
+        }
+        return path + ".o";
+    }
+
+    /*
+    Mixes `bytes` and their length into both 64-bit lanes of `key`, eight bytes at a time; the two
+    lanes use different multipliers, so together they form an independent 128-bit hash.
+    */
+    static void HASH(uint64_t (&key)[2], const std::string_view bytes) noexcept {
+        constexpr uint64_t MULTIPLIERS[2] = {0x9FB21C651E98DF25, 0xD6E8FEB86659FD93};
+        const auto mix = [&](const uint64_t word) {
+            for (int lane = 0; lane < 2; lane++) {
+                key[lane] = (key[lane] ^ word) * MULTIPLIERS[lane];
+                key[lane] ^= key[lane] >> 29;
+            }
+        };
+        size_t i = 0;
+
+        for (; i + 8 <= bytes.size(); i += 8) {
+            uint64_t word;
+            std::memcpy(&word, bytes.data() + i, 8);
+            mix(word);
+        }
+        uint64_t tail = 0;
+
+        if (i < bytes.size()) {
+            std::memcpy(&tail, bytes.data() + i, bytes.size() - i);
+        }
+        mix(tail);
+        mix(bytes.size());
+    }
+};
@@ -0,0 +1,151 @@
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "assembler.hpp"
+#include "object.hpp"
+#include "thread_pool.hpp"
+
+/*
+ParallelAssembler
+
+Assembles one large source on all workers of a ThreadPool.
+
+Steps:
+- Split: the source is cut into chunks of roughly equal size, each cut moved forward to the start
+  of the next line that defines a label at column 0. A statement never spans a line, and a label
+  flushes the Peephole window, so chunks parse the same on their own as in the whole. Sources with
+  macros or repetition blocks are not split: a macro defined in one chunk is used in others, and a
+  block spans lines.
+- Assemble: every chunk is lexed, parsed and encoded concurrently as a piece (see
+  Assembler::assemble_piece), which leaves its branches, aligns, label references and expressions
+  pending.
+- Join: the pieces are appended in order into one unit, whose label references, branches,
+  paddings and expressions are then settled over the whole code (padding depends on all the code
+  before it), so the output is the one Assembler::assemble
+  makes of the whole source, whatever the number of chunks.
+*/
+class ParallelAssembler {
+public:
+    static constexpr size_t MIN_CHUNK = 1 << 20; // Smaller sources are not worth splitting
+    static constexpr unsigned CHUNKS_PER_WORKER = 4; // Evens out chunks that take longer than others
+
+    std::vector<uint8_t> code; // Machine code of the last source assembled into direct output
+    std::vector<Diagnostic> diagnostics; // Errors of the last assembled source, in line order
+    bool optimize = false; // Run the Peephole pass (see Assembler::optimize)
+    FileLoader load_file = nullptr; // Reads `.incbin` files (see Assembler::load_file)
+    size_t included = 0; // Files the last assembled source read with .incbin
+
+    explicit ParallelAssembler(ThreadPool& pool) : pool(pool), pieces(CHUNKS_PER_WORKER * pool.size() + 1) {}
+
+    /*
+    Assembles `source` into `code`, exactly as Assembler::assemble(source) does.
+
+    Returns:
+    - the Program: `code` and `diagnostics`, true when the source assembled without errors.
+    */
+    Program assemble(const std::string_view source) {
+        if (assemble_chunks(source, false)) {
+            unit.assemble(std::span(pieces.data(), chunks.size()));
+        } else {
+            unit.assemble(source);
+        }
+        code.swap(unit.code);
+        diagnostics.swap(unit.diagnostics);
+        included = unit.included;
+        return {code, diagnostics};
+    }
+
+    /*
+    Assembles `source` into the relocatable `object` (object.name is kept), exactly as
+    Assembler::assemble(source, object) does.
+
+    Returns:
+    - true when the source assembled without errors.
+    */
+    bool assemble(const std::string_view source, Object& object) {
+        if (assemble_chunks(source, true)) {
+            unit.assemble(std::span(pieces.data(), chunks.size()), object);
+        } else {
+            unit.assemble(source, object);
+        }
+        diagnostics.swap(unit.diagnostics);
+        included = unit.included;
+        return diagnostics.empty();
+    }
+
+private:
+    ThreadPool& pool;
+    std::vector<Assembler> pieces; // Indexed like chunks, which are at most CHUNKS_PER_WORKER per worker
+    Assembler unit; // Joins the pieces
+    std::vector<std::string_view> chunks;
+
+    /*
+    Splits `source` and assembles its chunks as pieces (relocatable ones if `relocatable`) on the
+    pool, unless it is a single chunk.
+
+    Returns:
+    - whether `source` was split.
+    */
+    bool assemble_chunks(const std::string_view source, const bool relocatable) {
+        split(source);
+        unit.optimize = optimize;
+        unit.load_file = load_file;
+
+        if (chunks.size() == 1) {
+            return false;
+        }
+        pool.parallel_for(chunks.size(), [&](const size_t i, unsigned) {
+            pieces[i].optimize = optimize;
+            pieces[i].load_file = load_file;
+            pieces[i].assemble_piece(chunks[i], relocatable);
+        });
+        return true;
+    }
+
+    /*
+    Cuts `source` into about CHUNKS_PER_WORKER chunks per worker, each starting at a label definition.
+    */
+    void split(const std::string_view source) {
+        chunks.clear();
+
+        if (source.find(".macro") != source.npos || source.find(".rept") != source.npos || source.find(".irp") != source.npos) {
+            chunks.push_back(source);
+            return;
+        }
+        const size_t target = std::max(MIN_CHUNK, source.size() / (CHUNKS_PER_WORKER * pool.size()) + 1);
+        size_t start = 0;
+
+        while (source.size() - start > target) {
+            const size_t cut = LABEL_LINE(source, start + target);
+
+            if (cut == source.size()) {
+                break;
+            }
+            chunks.push_back(source.substr(start, cut - start));
+            start = cut;
+        }
+        chunks.push_back(source.substr(start));
+    }
+
+    /*
+    Returns the offset of the first line at or after `offset` that starts with `label:`, or the
+    source size.
+    */
+    static size_t LABEL_LINE(const std::string_view source, size_t offset) noexcept {
+        for (offset = source.find('\n', offset); offset != std::string_view::npos; offset = source.find('\n', offset + 1)) {
+            size_t end = offset + 1;
+
+            while (end < source.size() && (std::isalnum(static_cast<unsigned char>(source[end])) || source[end] == '_' || source[end] == '.' || source[end] == '$')) {
+                end++;
+            }
+            if (end > offset + 1 && end < source.size() && source[end] == ':' && !std::isdigit(static_cast<unsigned char>(source[offset + 1]))) {
+                return offset + 1;
+            }
+        }
+        return source.size();
+    }
+};
@@ -0,0 +1,292 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <vector>
+#include "isa.hpp"
+
+/*
+Peephole
+
+Optional optimization pass over the Assembler's instruction stream (Assembler::optimize). Encoded
+instructions pass through a two-instruction window before they reach the code, and every new
+instruction may rewrite the window:
+- MOV r, r is dropped.
+- MOV rX, 2^k followed by MUL rY, rX keeps the MOV and becomes SHL rY, k: MUL costs one adder pass
+  per multiplier bit and sixteen shifts, SHL one barrel-shifter pass.
+- MOV rX, d followed by DIV rY, rX keeps the MOV and divides by the constant without DIV, which
+  costs one subtraction per unit of the quotient (see Division by a constant).
+- CMP is dropped.
+- MOV temp, rS followed by an ADD, SUB, MOV or MAC reading temp is folded into that instruction,
+  which reads rS instead.
+
+Division by a constant (unsigned, Granlund-Montgomery):
+- d = 2^k: SHR rY, k.
+- Otherwise with a magic multiplier m and shift s (MAGIC), q = (x * m) >> (ARCHITECTURE + s):
+      MOV temp, m
+      MULH rY, temp       ; high half of x * m
+      SHR rY, s
+- Divisors whose magic multiplier needs ARCHITECTURE + 1 bits use its low bits m' and add the
+  dropped x back without overflowing, t = (x * m') >> ARCHITECTURE, q = (((x - t) >> 1) + t) >> (s - 1):
+      MOV r13, rY
+      MOV temp, m'
+      MULH r13, temp
+      SUB rY, r13
+      SHR rY, 1
+      ADD rY, r13
+      SHR rY, s - 1
+- The sequences end like DIV: ZF and SF follow the quotient, CF and OF are 0, so they need no
+  flag liveness, and they only write the registers DIV writes (rY, temp, r13).
+- A DIV with its dividend or divisor in r13 stays: the gate-level DIV overwrites r13 while it still
+  reads it, which the sequences do not reproduce.
+
+Liveness:
+- SHL leaves other flags than MUL, and a dropped CMP leaves none, so those rewrites
+  only apply when the next instruction overwrites every flag before any can be read: an ALU
+  operation other than INC and DEC (which keep CF). HLT does not qualify: the flags it leaves are
+  the program's final ALU state (Interpreter::alu). Likewise a fold needs the next instruction to
+  overwrite temp without reading it.
+- The Assembler flushes the window unchanged at every label, directive, branch and label
+  reference, so rewrites never cross a point control can enter from elsewhere, and a rewrite
+  whose next instruction is not known is not made.
+
+Conventions:
+- temp (r14), and the quotient register (r13) after DIV, are ALU scratch registers: what an ALU
+  operation leaves in them is not part of its result, so a rewrite may leave other values there.
+
+Listings:
+- Every instruction carries the source `line` it was pushed with, and a rewrite keeps the line of
+  the instruction it replaces, so `origins` attributes the code to the lines it came from even
+  though the window delays it.
+*/
+
+/*
+Where code came from, for listings: the code from `offset` up to the next Origin's offset was
+assembled from source line `line`.
+*/
+struct Origin {
+    uint32_t line;
+    uint32_t offset;
+    bool data = false; // Emitted by a data directive, not instructions
+    bool entry = false; // A label is placed at `offset`
+
+    /*
+    Appends the Origin of the code from `offset` on to `origins`, merging it into the last one when
+    that is from the same line and either starts at `offset` or is of the same kind.
+    */
+    static constexpr void trace(std::vector<Origin>& origins, const Origin origin) {
+        if (!origins.empty() && origins.back().line == origin.line && origins.back().offset == origin.offset) {
+            origins.back().data = origin.data;
+            origins.back().entry |= origin.entry;
+        } else if (origins.empty() || origins.back().line != origin.line || origins.back().data != origin.data || origin.entry) {
+            origins.push_back(origin);
+        }
+    }
+};
+
+class Peephole {
+public:
+    uint32_t line = 0; // Source line of the instructions pushed from now on
+    std::vector<Origin>* origins = nullptr; // When set, traces the line of every instruction encoded
+    /*
+    Adds `instruction` to the window, applying the rewrites it enables, and encodes the
+    instruction it pushes out of the window into `code`.
+    */
+    constexpr void push(const Instruction& instruction, std::vector<uint8_t>& code) {
+        if (instruction.opcode == Opcode::MOV_RR && instruction.operands[0] == instruction.operands[1]) {
+            return;
+        }
+        if (instruction.opcode == Opcode::DIV && count && CONSTANT(window[count - 1], instruction) && divide(instruction, window[count - 1], code)) {
+            return;
+        }
+        if (count && KILLS_FLAGS(instruction)) {
+            Instruction& last = window[count - 1];
+
+            if (last.opcode == Opcode::CMP) {
+                count--;
+            } else if (count == 2 && last.opcode == Opcode::MUL && CONSTANT(window[0], last) && std::has_single_bit(window[0].operands[1])) {
+                last = {Opcode::SHL, {last.operands[0], static_cast<uint16_t>(std::countr_zero(window[0].operands[1]))}};
+            }
+        }
+        if (count == 2 && FOLDABLE(window[0], window[1]) && KILLS_TEMP(instruction)) {
+            for (uint16_t& operand : window[1].operands) {
+                operand = operand == TEMP_REGISTER ? window[0].operands[1] : operand;
+            }
+            window[0] = window[1];
+            lines[0] = lines[1];
+            count = window[0].opcode == Opcode::MOV_RR && window[0].operands[0] == window[0].operands[1] ? 0 : 1;
+        }
+        if (count == window.size()) {
+            emit(0, code);
+            window[0] = window[1];
+            lines[0] = lines[1];
+            count--;
+        }
+        lines[count] = line;
+        window[count++] = instruction;
+    }
+
+    /*
+    Encodes the instructions left in the window into `code` as they are.
+    */
+    constexpr void flush(std::vector<uint8_t>& code) {
+        for (uint8_t i = 0; i < count; i++) {
+            emit(i, code);
+        }
+        count = 0;
+    }
+
+    /*
+    Magic multiplier of unsigned division by `divisor` (not a power of two): the smallest shift s
+    with a multiplier m = ceil(2^(ARCHITECTURE + s) / divisor) exact for every dividend.
+    */
+    struct Magic {
+        uint16_t multiplier; // m, or its low ARCHITECTURE bits when `wide`
+        uint8_t shift; // s
+        bool wide; // m needs ARCHITECTURE + 1 bits
+    };
+
+    static constexpr Magic MAGIC(const uint16_t divisor) noexcept {
+        for (uint8_t shift = 0; shift <= ARCHITECTURE; shift++) {
+            const uint64_t power = uint64_t(1) << (ARCHITECTURE + shift);
+            const uint64_t multiplier = (power + divisor - 1) / divisor;
+
+            // Exact for all dividends below 2^ARCHITECTURE iff the rounding error is at most 2^shift
+            if (multiplier * divisor - power <= uint64_t(1) << shift) {
+                if (multiplier >> ARCHITECTURE == 0) {
+                    return {static_cast<uint16_t>(multiplier), shift, false};
+                }
+                break;
+            }
+        }
+        const uint8_t shift = static_cast<uint8_t>(std::bit_width(static_cast<uint16_t>(divisor - 1))); // ceil(log2(divisor))
+        const uint64_t multiplier = ((uint64_t(1) << ARCHITECTURE) * ((uint64_t(1) << shift) - divisor)) / divisor + 1;
+        return {static_cast<uint16_t>(multiplier), shift, true};
+    }
+
+private:
+    std::array<Instruction, 2> window;
+    std::array<uint32_t, 2> lines = {}; // Source line of each instruction in the window
+    uint8_t count = 0; // Instructions in the window, oldest first
+
+    // Encodes window slot `slot` into `code`.
+    constexpr void emit(const uint8_t slot, std::vector<uint8_t>& code) {
+        uint8_t bytes[4];
+        encode(window[slot], bytes);
+
+        if (origins) {
+            Origin::trace(*origins, {lines[slot], static_cast<uint32_t>(code.size())});
+        }
+        code.insert(code.end(), bytes, bytes + instruction_size(window[slot].opcode));
+    }
+
+    // Whether opcode's ALU operation overwrites temp before reading it (see the ALU parameters).
+    static constexpr bool SCRATCH(const Opcode opcode) noexcept {
+        switch (opcode) {
+            case Opcode::MUL:
+            case Opcode::DIV:
+            case Opcode::NEG:
+            case Opcode::SHL:
+            case Opcode::SHR:
+            case Opcode::SAR:
+            case Opcode::ROL:
+            case Opcode::ROR:
+            case Opcode::CMP:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // Whether `instruction` names register `index` in any register operand.
+    static constexpr bool USES(const Instruction& instruction, const uint16_t index) noexcept {
+        const FormatInfo& format = format_info(instruction.opcode);
+
+        for (uint8_t i = 0; i < format.operand_count; i++) {
+            if (format.operands[i].kind == OperandKind::REGISTER && instruction.operands[i] == index) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Whether every flag is overwritten by `instruction` before it could be read.
+    static constexpr bool KILLS_FLAGS(const Instruction& instruction) noexcept {
+        return opcode_info(instruction.opcode).unit == Unit::ALU && instruction.opcode != Opcode::INC && instruction.opcode != Opcode::DEC;
+    }
+
+    // Whether temp is overwritten by `instruction` before it could be read.
+    static constexpr bool KILLS_TEMP(const Instruction& instruction) noexcept {
+        if (instruction.opcode == Opcode::HLT || (instruction.opcode == Opcode::MOV_RI && instruction.operands[0] == TEMP_REGISTER)) {
+            return true;
+        }
+        if (instruction.opcode == Opcode::MOV_RR) {
+            return instruction.operands[0] == TEMP_REGISTER && instruction.operands[1] != TEMP_REGISTER;
+        }
+        return SCRATCH(instruction.opcode) && !USES(instruction, TEMP_REGISTER);
+    }
+
+    // Whether `move` loads a constant into the divisor or multiplier of `operation` (MUL/DIV).
+    static constexpr bool CONSTANT(const Instruction& move, const Instruction& operation) noexcept {
+        return move.opcode == Opcode::MOV_RI && move.operands[0] == operation.operands[1] && move.operands[0] != TEMP_REGISTER &&
+               operation.operands[0] != operation.operands[1] && operation.operands[0] != TEMP_REGISTER;
+    }
+
+    /*
+    Pushes the DIV-free division of `division`'s lhs by the constant `move` loads (see Division by a
+    constant).
+
+    Returns:
+    - false if the division has to stay a DIV: divisor 0, or the dividend or divisor in r13, which
+      the gate-level DIV overwrites while it reads them.
+    */
+    constexpr bool divide(const Instruction& division, const Instruction& move, std::vector<uint8_t>& code) {
+        const uint16_t dividend = division.operands[0];
+        const uint16_t divisor = move.operands[1];
+
+        if (divisor == 0 || dividend == QUOTIENT_REGISTER || move.operands[0] == QUOTIENT_REGISTER) {
+            return false;
+        }
+        if (std::has_single_bit(divisor)) {
+            push({Opcode::SHR, {dividend, static_cast<uint16_t>(std::countr_zero(divisor))}}, code);
+            return true;
+        }
+        const Magic magic = MAGIC(divisor);
+
+        if (!magic.wide) {
+            push({Opcode::MOV_RI, {TEMP_REGISTER, magic.multiplier}}, code);
+            push({Opcode::MULH, {dividend, TEMP_REGISTER}}, code);
+
+            if (magic.shift) {
+                push({Opcode::SHR, {dividend, magic.shift}}, code);
+            }
+            return true;
+        }
+        push({Opcode::MOV_RR, {QUOTIENT_REGISTER, dividend}}, code);
+        push({Opcode::MOV_RI, {TEMP_REGISTER, magic.multiplier}}, code);
+        push({Opcode::MULH, {QUOTIENT_REGISTER, TEMP_REGISTER}}, code);
+        push({Opcode::SUB, {dividend, QUOTIENT_REGISTER}}, code);
+        push({Opcode::SHR, {dividend, 1}}, code);
+        push({Opcode::ADD, {dividend, QUOTIENT_REGISTER}}, code);
+        push({Opcode::SHR, {dividend, static_cast<uint16_t>(magic.shift - 1)}}, code);
+        return true;
+    }
+
+    // Whether `move` copies a register into temp that `operation` only reads.
+    static constexpr bool FOLDABLE(const Instruction& move, const Instruction& operation) noexcept {
+        if (move.opcode != Opcode::MOV_RR || move.operands[0] != TEMP_REGISTER) {
+            return false;
+        }
+        switch (operation.opcode) {
+            case Opcode::ADD:
+            case Opcode::SUB:
+            case Opcode::MOV_RR:
+                return operation.operands[1] == TEMP_REGISTER && operation.operands[0] != TEMP_REGISTER;
+            case Opcode::MAC:
+                return (operation.operands[2] == TEMP_REGISTER || operation.operands[3] == TEMP_REGISTER) &&
+                       operation.operands[0] != TEMP_REGISTER && operation.operands[1] != TEMP_REGISTER;
+            default:
+                return false;
+        }
+    }
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+/*
+PerfectHash
+
+Collision-free, case-insensitive lookup of short names (at most 4 characters), built entirely at
+compile time.
+
+Scheme:
+- A name is packed into a 32-bit key: one ASCII-case-folded byte per character, little-endian,
+  zero-padded. Folding sets bit 5, which maps letters to lowercase and leaves digits, '.', '$'
+  unchanged, so two identifiers share a key exactly when they differ only in letter case.
+- The slot is the top BITS bits of `key * seed`. The constructor searches odd seeds until every
+  name lands in its own slot of the 2^BITS table.
+- A lookup is one multiply-shift and one key compare; nothing is built at runtime.
+
+Template parameters:
+- T: value type stored per name.
+- N: number of names.
+- BITS: log2 of the table size, by default the smallest power of two holding 4 * N slots. At most a
+  quarter of the slots are used, so a collision-free seed turns up within a few dozen attempts and
+  the search stays well inside the compiler's constant-evaluation limits.
+*/
+template <typename T, size_t N, uint8_t BITS = std::bit_width(4 * N - 1)>
+class PerfectHash {
+public:
+    static constexpr uint8_t MAX_LENGTH = 4;
+
+    /*
+    Builds the table from (name, value) pairs. Names must be unique ignoring case and at most
+    MAX_LENGTH characters long; otherwise valid() is false.
+    */
+    constexpr explicit PerfectHash(const std::array<std::pair<std::string_view, T>, N>& entries) noexcept {
+        for (uint32_t candidate = 0x9E3779B1; candidate != 0x9E3779B1 + 2 * SEED_ATTEMPTS; candidate += 2) {
+            std::array<bool, SIZE> used{};
+            bool collision = false;
+
+            for (const auto& [name, value] : entries) {
+                const uint32_t slot = SLOT(KEY(name), candidate);
+                collision |= name.empty() || name.size() > MAX_LENGTH || used[slot];
+                used[slot] = true;
+            }
+            if (!collision) {
+                seed = candidate;
+
+                for (const auto& [name, value] : entries) {
+                    table[SLOT(KEY(name), seed)] = {KEY(name), value};
+                }
+                return;
+            }
+        }
+    }
+
+    /*
+    Whether the constructor found a collision-free seed.
+    */
+    constexpr bool valid() const noexcept { return seed != 0; }
+
+    /*
+    Returns the value stored for `name` (ignoring case), or nullptr if there is none.
+    */
+    constexpr const T* find(const std::string_view name) const noexcept {
+        if (name.empty() || name.size() > MAX_LENGTH) {
+            return nullptr;
+        }
+        const uint32_t key = KEY(name);
+        const Entry& entry = table[SLOT(key, seed)];
+        return entry.key == key ? &entry.value : nullptr;
+    }
+
+private:
+    static constexpr size_t SIZE = size_t(1) << BITS;
+    static constexpr uint32_t SEED_ATTEMPTS = 1 << 16;
+
+    struct Entry {
+        uint32_t key = 0; // 0 never matches: every packed name has a non-zero first byte
+        T value{};
+    };
+
+    uint32_t seed = 0;
+    std::array<Entry, SIZE> table{};
+
+    static constexpr uint32_t KEY(const std::string_view name) noexcept {
+        uint32_t key = 0;
+
+        for (size_t i = 0; i < name.size() && i < MAX_LENGTH; i++) {
+            key |= static_cast<uint32_t>(static_cast<uint8_t>(name[i]) | 0x20) << (8 * i);
+        }
+        return key;
+    }
+
+    static constexpr uint32_t SLOT(const uint32_t key, const uint32_t seed) noexcept { return key * seed >> (32 - BITS); }
+};
@@ -1,4 +1,6 @@
 #pragma once
+#include <array>
+#include <bit>
 #include "bit.hpp"
 
 /*
@@ -76,6 +78,58 @@ public:
     */
     constexpr Bit MSB() const noexcept { return bits[ARCHITECTURE - 1]; }
 
+    /*
+    Gathers byte `index` of the register (bits 8 * index .. 8 * index + 7) into an integer.
+
+    On little-endian hosts the eight bits are reinterpreted as one 64-bit word (one 0/1 byte per
+    bit) and packed with a single multiply; otherwise they are gathered bit by bit.
+
+    Parameters:
+    - index: Byte position, 0 being the least significant byte.
+
+    Returns:
+    - uint8_t: Bit i of the result is bit 8 * index + i of the register.
+    */
+    constexpr uint8_t BYTE(const uint8_t index) const noexcept {
+        std::array<Bit, 8> slice = {};
+
+        for (uint8_t i = 0; i < 8; i++) {
+            slice[i] = bits[8 * index + i];
+        }
+        if constexpr (std::endian::native == std::endian::little) {
+            return std::bit_cast<unsigned long long>(slice) * 0x0102040810204080ULL >> 56;
+        }
+        uint8_t value = 0;
+
+        for (uint8_t i = 0; i < 8; i++) {
+            value |= static_cast<bool>(slice[i]) << i;
+        }
+        return value;
+    }
+
+    /*
+    Scatters `value` into byte `index` of the register; the inverse of BYTE.
+
+    Parameters:
+    - index: Byte position, 0 being the least significant byte.
+    - value: Bit i is stored into bit 8 * index + i of the register.
+    */
+    constexpr void SET_BYTE(const uint8_t index, const uint8_t value) noexcept {
+        std::array<Bit, 8> slice = {};
+
+        if constexpr (std::endian::native == std::endian::little) {
+            const unsigned long long spread = value * 0x0101010101010101ULL & 0x8040201008040201ULL;
+            slice = std::bit_cast<std::array<Bit, 8>>((spread + 0x7F7F7F7F7F7F7F7FULL) >> 7 & 0x0101010101010101ULL);
+        } else {
+            for (uint8_t i = 0; i < 8; i++) {
+                slice[i] = (value >> i & 1) != 0;
+            }
+        }
+        for (uint8_t i = 0; i < 8; i++) {
+            bits[8 * index + i] = slice[i];
+        }
+    }
+
     /*
     Allocates 16 registers dynamically.
 
@@ -84,9 +138,10 @@ public:
 
     Notes:
     - It is the caller's responsibility to clear or initialize these registers as needed.
-    - Caller must delete[] the returned pointer when done.
+    - Caller must delete[] the returned pointer when done; in a constant expression, before the
+      evaluation ends.
     */
-    static Register* instantiate_register_set() noexcept { return new Register[16]; }
+    static constexpr Register* instantiate_register_set() noexcept { return new Register[16]; }
 
     // Disable assignment to enforce immutability after creation
     constexpr Register& operator=(const Register&) = delete;
@@ -0,0 +1,114 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ThreadPool
+
+Fixed set of worker threads for data-parallel loops. The calling thread joins in as worker 0, so a
+pool of size 1 runs everything inline without any threads.
+
+parallel_for hands out indices one at a time from a shared atomic counter, so uneven tasks (source
+files of very different sizes) balance themselves across the workers.
+*/
+class ThreadPool {
+public:
+    /*
+    Parameters:
+    - threads: number of workers including the caller; 0 means one per hardware thread.
+    */
+    explicit ThreadPool(unsigned threads = 0) {
+        threads = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+
+        for (unsigned worker = 1; worker < threads; worker++) {
+            workers.emplace_back([this, worker] { run(worker); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+
+        for (std::thread& thread : workers) {
+            thread.join();
+        }
+    }
+
+    /*
+    Number of workers, including the calling thread.
+    */
+    unsigned size() const noexcept { return static_cast<unsigned>(workers.size()) + 1; }
+
+    /*
+    Calls task(index, worker) for every index in [0, count) and returns once all calls have finished.
+    `worker` is in [0, size()) and identifies the calling worker, for per-worker scratch state.
+    */
+    void parallel_for(const size_t count, const std::function<void(size_t, unsigned)>& task) {
+        {
+            std::lock_guard lock(mutex);
+            job = &task;
+            total = count;
+            next = 0;
+            active = static_cast<unsigned>(workers.size());
+            generation++;
+        }
+        wake.notify_all();
+        work(0);
+        std::unique_lock lock(mutex);
+        done.wait(lock, [this] { return active == 0; });
+        job = nullptr;
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake; // Signals a new job or shutdown to the workers
+    std::condition_variable done; // Signals the caller that the last worker finished
+    const std::function<void(size_t, unsigned)>* job = nullptr;
+    size_t total = 0;
+    std::atomic<size_t> next = 0;
+    unsigned active = 0; // Workers (besides the caller) still busy with the current job
+    uint64_t generation = 0;
+    bool stopping = false;
+
+    void work(const unsigned worker) {
+        for (size_t index = next.fetch_add(1, std::memory_order_relaxed); index < total; index = next.fetch_add(1, std::memory_order_relaxed)) {
+            (*job)(index, worker);
+        }
+    }
+
+    void run(const unsigned worker) {
+        uint64_t seen = 0;
+
+        for (;;) {
+            {
+                std::unique_lock lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+
+                if (stopping) {
+                    return;
+                }
+                seen = generation;
+            }
+            work(worker);
+            std::lock_guard lock(mutex);
+
+            if (--active == 0) {
+                done.notify_one();
+            }
+        }
+    }
+};